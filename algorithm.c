@@ -4,6 +4,9 @@
  * Suitable for Contiki-NG embedded environment
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include "contiki.h"
 #include "sys/log.h"
 #include <stdio.h>
@@ -11,28 +14,112 @@
 #include <stdlib.h>
 #include <time.h>
 #include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <stdint.h>
+#include <linux/perf_event.h>
+#include <math.h>
+#include <limits.h>
+#include <spawn.h>
+#include <sys/wait.h>
 
 #define LOG_MODULE "CUT-MESH"
 #define LOG_LEVEL LOG_LEVEL_INFO
 
-/* Adjust MAX_NODES based on your needs (50-200 recommended for stability) */
+/* Adjust MAX_NODES based on your needs (50-200 recommended for stability).
+ * All three limits can be overridden from the build (CFLAGS += -DMAX_NODES=...). */
+#ifndef MAX_NODES
 #define MAX_NODES 1000
+#endif
+#ifndef MAX_NEIGHBORS
 #define MAX_NEIGHBORS 80
+#endif
+#ifndef MAX_BLOCKS
 #define MAX_BLOCKS 1250
+#endif
+#define EDGE_STACK_SIZE (MAX_NODES * 10)
 
 /* External variables for command-line args */
 extern int contiki_argc;
 extern char **contiki_argv;
+extern char **environ;
 
 /* Configuration */
 static int n_nodes = 50;
 static double connection_prob = 0.15;
 
+/* Topology families. Everything except TOPO_RANDOM is an adversarial
+ * shape aimed at one code path (see generate_topology()). */
+typedef enum {
+  TOPO_RANDOM = 0,
+  TOPO_PATH,          /* deepest possible DFS: recursion depth == n */
+  TOPO_STAR_CHAINS,   /* root with pendant chains: max blocks and leaves */
+  TOPO_BIPARTITE,     /* complete bipartite core: max edge stack */
+  TOPO_HUB,           /* one hub wired to everyone: exceeds MAX_NEIGHBORS */
+  TOPO_PETALS,        /* rings through the root: leaf blocks with a choice */
+  TOPO_COUNT
+} topology_kind_t;
+
+static const char *topology_names[TOPO_COUNT] = {
+  "random", "path", "star-chains", "bipartite", "hub", "petals"
+};
+
+static topology_kind_t topology_kind = TOPO_RANDOM;
+static int stress_mode = 0;
+static int stress_chain_len = 4;
+
+/* External-memory mode */
+static const char *external_file = NULL;
+static const char *export_csr_file = NULL;
+static int external_gen_nodes = 0;
+static long mem_budget_mb = 64;
+static int external_hier = 0;      /* partitioned analysis of the file */
+static int numa_bench_nodes = 0;
+static int tlb_bench_nodes = 0;
+static int prefetch_bench_nodes = 0;
+static int engine_bench_nodes = 0;
+static int blocks_bench = 0;
+static int whatif_bench_plans = 0;
+static int whatif_bench_nodes = 0;
+static int version_bench_nodes = 0;
+static int sssp_bench_nodes = 0;
+static int hier_bench_nodes = 0;
+static int verify_threads = 0;
+static int hier_parts = 0;         /* 0: one partition per HIER_PART_NODES */
+static int query_bench = 0;
+
+/* Cooperative mode: analysis time slice per scheduler poll in ms
+ * (0 runs the whole analysis in one go) */
+static double coop_slice_ms = 0.0;
+
+/* Simulated seconds for the in-process mote simulation (0 = off) */
+static double sim_seconds = 0.0;
+
+/* Software prefetch look-ahead of the CSR DFS, in adjacency entries
+ * (0 disables prefetching) */
+static int prefetch_distance = 0;
+
 /* Graph structures - static allocation */
 static int neighbors[MAX_NODES][MAX_NEIGHBORS];
 static int degree[MAX_NODES];
 static char exists_edge[MAX_NODES][MAX_NODES];
 
+/* Node positions in metres, consistent with the links (see
+ * assign_positions()) */
+#define RADIO_RANGE 50.0
+static double node_x[MAX_NODES];
+static double node_y[MAX_NODES];
+
+/* Battery level of each mote, from near empty to 1.0 (mains powered) */
+static double node_battery[MAX_NODES];
+
 /* Tarjan arrays */
 static int disc[MAX_NODES];
 static int low[MAX_NODES];
@@ -46,25 +133,84 @@ typedef struct {
   int u, v;
 } Edge;
 
-static Edge edge_stack[MAX_NODES * 10];
+static Edge edge_stack[EDGE_STACK_SIZE];
 static int stack_top = 0;
 
+/* Vertex stack for block extraction: each vertex is pushed once at
+ * discovery, so blocks pop straight off it without dedupe */
+typedef enum { EXTRACT_EDGE_STACK = 0, EXTRACT_VERTEX_STACK } extraction_t;
+
+static const char *extraction_names[] = { "edge", "vertex" };
+static extraction_t block_extraction = EXTRACT_EDGE_STACK;
+
+static int vertex_stack[MAX_NODES];
+static int vstack_top = 0;
+
+/* Worst-case bookkeeping for the stress benchmark. stack_peak counts
+ * entries of whichever block stack is in use. */
+static int stack_peak = 0;
+static int stack_overflows = 0;
+static int dfs_depth = 0;
+static int dfs_depth_peak = 0;
+static char *dfs_stack_base = NULL;
+static char *dfs_stack_deepest = NULL;
+
 /* Biconnected components - compact representation */
 static int block_nodes[MAX_BLOCKS][MAX_NODES];
 static int block_size[MAX_BLOCKS];
 static int num_blocks = 0;
 
+/* block_nodes/block_size describe the current graph. Cut-vertex-only
+ * passes and graph edits clear it; ensure_blocks() rebuilds on demand. */
+static char blocks_valid = 0;
+
 /* Block-cut tree */
 static char is_leaf_block[MAX_BLOCKS];
 static int leaf_blocks[MAX_BLOCKS];
 static int num_leaf_blocks = 0;
 
+/* Augmentation endpoint chosen for each leaf block, by leaf index */
+static int leaf_candidate[MAX_BLOCKS];
+
+/* Cut vertex attaching each leaf block to the rest of the BCT */
+static int leaf_cut[MAX_BLOCKS];
+
+/* Order in which leaves are paired: 0-1, 2-3, ... */
+typedef enum { PAIR_SEQUENTIAL = 0, PAIR_SPATIAL } pairing_t;
+
+static const char *pairing_names[] = { "sequential", "spatial" };
+static pairing_t pairing_mode = PAIR_SEQUENTIAL;
+static int leaf_order[MAX_BLOCKS];
+static Edge leaf_links[MAX_BLOCKS / 2 + 1];
+static int heal_rounds = 1;
+
+/* How a leaf pair is joined: a direct link, or a chain of relay motes
+ * when the two endpoints are out of radio range */
+typedef enum { AUGMENT_DIRECT = 0, AUGMENT_RELAY } augment_t;
+
+static const char *augment_names[] = { "direct", "relay" };
+static augment_t augment_mode = AUGMENT_DIRECT;
+static char is_relay[MAX_NODES];
+
+/* Endpoint chosen in each leaf block: the lowest id, or the cheapest by
+ * link_energy_cost() from a per-leaf priority queue */
+typedef enum { SELECT_LOWEST_ID = 0, SELECT_ENERGY } select_t;
+
+static const char *select_names[] = { "id", "energy" };
+static select_t select_mode = SELECT_LOWEST_ID;
+
 /* Redundant edge tracking */
 static char redundant_edge[MAX_NODES][MAX_NODES];
 
 /* Statistics */
 static int original_edges = 0;
+static unsigned int topology_seed = 0;   /* 0: seed from the clock */
 static int redundant_edges_added = 0;
+static int dropped_edges = 0;
+static double added_link_length = 0.0;
+static int relays_added = 0;
+static double added_link_energy = 0.0;
+static double min_endpoint_battery = 1.0;
 
 /* Timing statistics */
 static double time_topology_gen = 0.0;
@@ -90,6 +236,46 @@ double get_time_ms(void) {
   return (tv.tv_sec * 1000.0) + (tv.tv_usec / 1000.0);
 }
 
+long peak_rss_kb(void) {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+/* ----------------- Hardware counters ------------------ */
+
+/* Thin perf_event_open(2) wrapper for the memory benchmarks. Returns -1
+ * when counters are unavailable (containers, perf_event_paranoid). */
+int perf_counter_open(unsigned int type, unsigned long long config) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  if(fd >= 0) {
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+  return fd;
+}
+
+long long perf_counter_close(int fd) {
+  long long value = -1;
+  if(fd < 0) return -1;
+  ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+  if(read(fd, &value, sizeof(value)) != sizeof(value)) value = -1;
+  close(fd);
+  return value;
+}
+
+#define DTLB_READ_MISS (PERF_COUNT_HW_CACHE_DTLB | \
+                        (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
 /* ----------------- Initialization ------------------ */
 
 void init_arrays(void) {
@@ -101,17 +287,32 @@ void init_arrays(void) {
   memset(is_leaf_block, 0, sizeof(is_leaf_block));
   original_edges = 0;
   redundant_edges_added = 0;
+  dropped_edges = 0;
+  added_link_length = 0.0;
+  relays_added = 0;
+  added_link_energy = 0.0;
+  min_endpoint_battery = 1.0;
+  memset(is_relay, 0, sizeof(is_relay));
   num_blocks = 0;
+  blocks_valid = 0;
   stack_top = 0;
 }
 
 /* ----------------- Graph generation ------------------ */
 
+static inline unsigned int hash_u32(unsigned int x) {
+  x ^= x >> 16; x *= 0x7feb352dU;
+  x ^= x >> 15; x *= 0x846ca68bU;
+  x ^= x >> 16;
+  return x;
+}
+
 void generate_random_topology(void) {
-  unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)clock();
+  unsigned int seed = topology_seed ? topology_seed
+                                    : (unsigned int)time(NULL) ^ (unsigned int)clock();
   srand(seed);
   
-  LOG_INFO("Generating random topology with %d nodes...\n", n_nodes);
+  LOG_INFO("Generating random topology with %d nodes (seed %u)...\n", n_nodes, seed);
   
   /* Step 1: Create tree backbone */
   for(int i=1; i<n_nodes; i++) {
@@ -152,6 +353,151 @@ void generate_random_topology(void) {
            n_nodes, original_edges, 2.0 * original_edges / n_nodes);
 }
 
+/* Adds u--v unless it already exists or would overflow MAX_NEIGHBORS.
+ * Rejections due to the degree cap are counted in dropped_edges. */
+static int add_edge(int u, int v) {
+  if(u == v || exists_edge[u][v]) return 0;
+  if(degree[u] >= MAX_NEIGHBORS || degree[v] >= MAX_NEIGHBORS) {
+    dropped_edges++;
+    return 0;
+  }
+  neighbors[u][degree[u]++] = v;
+  neighbors[v][degree[v]++] = u;
+  exists_edge[u][v] = exists_edge[v][u] = 1;
+  original_edges++;
+  return 1;
+}
+
+/* Path 0-1-...-(n-1): every inner node is a cut vertex and the DFS
+ * recursion reaches depth n. */
+static void generate_path_topology(void) {
+  for(int i=1; i<n_nodes; i++) add_edge(i - 1, i);
+}
+
+/* Root 0 with pendant chains of stress_chain_len nodes. Every edge is a
+ * bridge block, and each chain end is a leaf block for augmentation.
+ * Once the root is full, new chains hang off the previous chain's head. */
+static void generate_star_chains_topology(void) {
+  int len = stress_chain_len > 0 ? stress_chain_len : 1;
+  for(int i=1; i<n_nodes; i++) {
+    if((i - 1) % len != 0) {
+      add_edge(i - 1, i);
+    } else if(!add_edge(0, i)) {
+      add_edge(i - len, i);
+    }
+  }
+}
+
+/* Complete bipartite core K(a,a), sides capped below MAX_NEIGHBORS so the
+ * core itself never drops an edge; the core pushes a*a edges onto the
+ * edge stack before a single block is popped. Remaining nodes hang off
+ * the core as a tail. */
+static void generate_bipartite_topology(void) {
+  int a = n_nodes / 2;
+  if(a > MAX_NEIGHBORS - 1) a = MAX_NEIGHBORS - 1;
+
+  for(int i=0; i<a; i++) {
+    for(int j=0; j<a; j++) add_edge(i, a + j);
+  }
+  for(int i=2 * a; i<n_nodes; i++) add_edge(i - 1, i);
+}
+
+/* Node 0 tries to link to everyone, so all links beyond MAX_NEIGHBORS are
+ * rejected; rejected nodes fall back to their predecessor to stay
+ * connected. */
+static void generate_hub_topology(void) {
+  for(int i=1; i<n_nodes; i++) {
+    if(!add_edge(0, i)) add_edge(i - 1, i);
+  }
+}
+
+/* Root 0 with rings of stress_chain_len motes, each closed through the
+ * root. Every ring is a leaf block whose motes are all non-cut, so link
+ * endpoints can be chosen among them. Once the root is full, rings
+ * close through the first mote of the previous ring instead. */
+static void generate_petals_topology(void) {
+  int len = stress_chain_len > 1 ? stress_chain_len : 2;
+  int hub = 0;
+  for(int first=1; first<n_nodes; first+=len) {
+    int last = first + len - 1 < n_nodes ? first + len - 1 : n_nodes - 1;
+    for(int i=first; i<last; i++) add_edge(i, i + 1);
+    if(degree[hub] > MAX_NEIGHBORS - 2) hub = first - len;
+    add_edge(hub, first);
+    add_edge(hub, last);
+  }
+}
+
+/* Places the root at the origin and every other node at 0.3-1.0 radio
+ * ranges from its BFS parent, in a direction hashed from its id, so
+ * geometry follows the links. Unreached nodes start a new tree offset
+ * from the last one placed. */
+void assign_positions(void) {
+  static int queue[MAX_NODES];
+  static char placed[MAX_NODES];
+  memset(placed, 0, sizeof(placed));
+  double last_x = 0.0, last_y = 0.0;
+
+  for(int r=0; r<n_nodes; r++) {
+    if(placed[r]) continue;
+    int head = 0, tail = 0;
+    node_x[r] = r == 0 ? 0.0 : last_x + 2.0 * RADIO_RANGE;
+    node_y[r] = r == 0 ? 0.0 : last_y;
+    placed[r] = 1;
+    queue[tail++] = r;
+
+    while(head < tail) {
+      int u = queue[head++];
+      last_x = node_x[u];
+      last_y = node_y[u];
+      for(int i=0; i<degree[u]; i++) {
+        int v = neighbors[u][i];
+        if(placed[v]) continue;
+        unsigned int h = hash_u32((unsigned int)v * 2654435761U);
+        double angle = (h & 0xffff) * (2.0 * M_PI / 65536.0);
+        double dist = RADIO_RANGE * (0.3 + 0.7 * (h >> 16) / 65536.0);
+        node_x[v] = node_x[u] + dist * cos(angle);
+        node_y[v] = node_y[u] + dist * sin(angle);
+        placed[v] = 1;
+        queue[tail++] = v;
+      }
+    }
+  }
+}
+
+/* Root 0 is mains powered; every other mote gets a hashed battery level
+ * between 5% and 100% */
+void assign_batteries(void) {
+  node_battery[0] = 1.0;
+  for(int i=1; i<n_nodes; i++) {
+    node_battery[i] = 0.05 + 0.95 * (hash_u32((unsigned int)i ^ 0x5bd1e995U) & 0xffff) / 65536.0;
+  }
+}
+
+static inline double node_distance(int a, int b) {
+  double dx = node_x[a] - node_x[b], dy = node_y[a] - node_y[b];
+  return sqrt(dx * dx + dy * dy);
+}
+
+void generate_topology(void) {
+  switch(topology_kind) {
+  case TOPO_PATH:        generate_path_topology(); break;
+  case TOPO_STAR_CHAINS: generate_star_chains_topology(); break;
+  case TOPO_BIPARTITE:   generate_bipartite_topology(); break;
+  case TOPO_HUB:         generate_hub_topology(); break;
+  case TOPO_PETALS:      generate_petals_topology(); break;
+  default:
+    generate_random_topology();
+    assign_positions();
+    assign_batteries();
+    return;
+  }
+
+  assign_positions();
+  assign_batteries();
+  LOG_INFO("Generated %s: %d nodes, %d edges (%d dropped at MAX_NEIGHBORS)\n",
+           topology_names[topology_kind], n_nodes, original_edges, dropped_edges);
+}
+
 /* ----------------- Tarjan DFS ------------------ */
 
 void tarjan_dfs_bicomp(int u) {
@@ -159,25 +505,36 @@ void tarjan_dfs_bicomp(int u) {
   disc[u] = low[u] = ++time_dfs;
   int children = 0;
 
+  /* Recursion depth and real call-stack usage, sampled at the deepest frame */
+  if(++dfs_depth > dfs_depth_peak) {
+    dfs_depth_peak = dfs_depth;
+    if(dfs_depth == 1) dfs_stack_base = (char *)&children;
+    dfs_stack_deepest = (char *)&children;
+  }
+
   for(int i=0; i<degree[u]; i++){
     int v = neighbors[u][i];
     if(!visited[v]) {
       children++;
       parent_tarjan[v] = u;
       
-      if(stack_top < MAX_NODES * 10 - 1) {
+      if(stack_top < EDGE_STACK_SIZE - 1) {
         edge_stack[stack_top].u = u;
         edge_stack[stack_top].v = v;
         stack_top++;
+        if(stack_top > stack_peak) stack_peak = stack_top;
+      } else {
+        stack_overflows++;
       }
       
       tarjan_dfs_bicomp(v);
       
       if(low[v] < low[u]) low[u] = low[v];
 
-      if( (parent_tarjan[u] == -1 && children > 1) ||
-          (parent_tarjan[u] != -1 && low[v] >= disc[u]) ) {
-        is_cut[u] = 1;
+      if(low[v] >= disc[u]) {
+        /* The root only separates once it has a second DFS child, but
+         * every child subtree of the root closes a block of its own */
+        if(parent_tarjan[u] != -1 || children > 1) is_cut[u] = 1;
         
         /* Pop edges and form component */
         if(num_blocks < MAX_BLOCKS) {
@@ -199,36 +556,125 @@ void tarjan_dfs_bicomp(int u) {
           } while(!(e.u == u && e.v == v) && stack_top > 0);
           
           num_blocks++;
+        } else {
+          /* Past MAX_BLOCKS the block's edges are still popped */
+          while(stack_top > 0) {
+            Edge e = edge_stack[--stack_top];
+            if(e.u == u && e.v == v) break;
+          }
         }
       }
     } else if(v != parent_tarjan[u] && disc[v] < disc[u]) {
-      if(stack_top < MAX_NODES * 10 - 1) {
+      if(stack_top < EDGE_STACK_SIZE - 1) {
         edge_stack[stack_top].u = u;
         edge_stack[stack_top].v = v;
         stack_top++;
+        if(stack_top > stack_peak) stack_peak = stack_top;
+      } else {
+        stack_overflows++;
       }
       
       if(disc[v] < low[u]) low[u] = disc[v];
     }
   }
   
-  /* Handle remaining edges for root */
-  if(parent_tarjan[u] == -1 && children <= 1 && stack_top > 0 && num_blocks < MAX_BLOCKS) {
-    char in_block[MAX_NODES] = {0};
-    while(stack_top > 0) {
-      stack_top--;
-      Edge e = edge_stack[stack_top];
-      
-      if(!in_block[e.u]) {
-        in_block[e.u] = 1;
-        block_nodes[num_blocks][block_size[num_blocks]++] = e.u;
-      }
-      if(!in_block[e.v]) {
-        in_block[e.v] = 1;
-        block_nodes[num_blocks][block_size[num_blocks]++] = e.v;
+  dfs_depth--;
+}
+
+/* Same DFS as tarjan_dfs_bicomp, extracting blocks from a vertex stack:
+ * when child v closes a block at u, the block is everything above and
+ * including v on the stack, plus u. O(V) stack, no per-frame dedupe
+ * array, and the same blocks in the same order. */
+void tarjan_dfs_vstack(int u) {
+  visited[u] = 1;
+  disc[u] = low[u] = ++time_dfs;
+  int children = 0;
+
+  if(++dfs_depth > dfs_depth_peak) {
+    dfs_depth_peak = dfs_depth;
+    if(dfs_depth == 1) dfs_stack_base = (char *)&children;
+    dfs_stack_deepest = (char *)&children;
+  }
+
+  vertex_stack[vstack_top++] = u;
+  if(vstack_top > stack_peak) stack_peak = vstack_top;
+
+  for(int i=0; i<degree[u]; i++) {
+    int v = neighbors[u][i];
+    if(!visited[v]) {
+      children++;
+      parent_tarjan[v] = u;
+
+      tarjan_dfs_vstack(v);
+
+      if(low[v] < low[u]) low[u] = low[v];
+
+      if(low[v] >= disc[u]) {
+        if(parent_tarjan[u] != -1 || children > 1) is_cut[u] = 1;
+
+        int w;
+        if(num_blocks < MAX_BLOCKS) {
+          do {
+            w = vertex_stack[--vstack_top];
+            block_nodes[num_blocks][block_size[num_blocks]++] = w;
+          } while(w != v);
+          block_nodes[num_blocks][block_size[num_blocks]++] = u;
+          num_blocks++;
+        } else {
+          do { w = vertex_stack[--vstack_top]; } while(w != v);
+        }
       }
+    } else if(v != parent_tarjan[u] && disc[v] < low[u]) {
+      low[u] = disc[v];
+    }
+  }
+
+  dfs_depth--;
+}
+
+static int compare_ints(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+/* Two blocks share at most one node, so the two lowest members tell
+ * them apart */
+static int compare_blocks(const void *a, const void *b) {
+  const int *x = block_nodes[*(const int *)a], *y = block_nodes[*(const int *)b];
+  if(x[0] != y[0]) return x[0] < y[0] ? -1 : 1;
+  return (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+/* Canonical block ids: members ascending, blocks ordered by their two
+ * lowest members. Ids then depend only on the graph, not on the DFS
+ * order, the extraction method or the engine that found the blocks. */
+void canonical_blocks(void) {
+  static int order[MAX_BLOCKS], row[MAX_NODES];
+  static char placed[MAX_BLOCKS];
+
+  for(int b=0; b<num_blocks; b++) {
+    qsort(block_nodes[b], block_size[b], sizeof(int), compare_ints);
+    order[b] = b;
+    placed[b] = 0;
+  }
+  qsort(order, num_blocks, sizeof(int), compare_blocks);
+
+  /* Block i takes old block order[i], one permutation cycle at a time */
+  for(int i=0; i<num_blocks; i++) {
+    if(placed[i]) continue;
+    int size = block_size[i];
+    memcpy(row, block_nodes[i], sizeof(int) * size);
+    int j = i;
+    while(order[j] != i) {
+      int k = order[j];
+      memcpy(block_nodes[j], block_nodes[k], sizeof(int) * block_size[k]);
+      block_size[j] = block_size[k];
+      placed[j] = 1;
+      j = k;
     }
-    num_blocks++;
+    memcpy(block_nodes[j], row, sizeof(int) * size);
+    block_size[j] = size;
+    placed[j] = 1;
   }
 }
 
@@ -243,168 +689,4082 @@ void find_biconnected_components(void) {
   num_blocks = 0;
   stack_top = 0;
   time_dfs = 0;
+  stack_peak = 0;
+  stack_overflows = 0;
+  dfs_depth = 0;
+  dfs_depth_peak = 0;
+  dfs_stack_base = dfs_stack_deepest = NULL;
   
   for(int i=0; i<n_nodes; i++){
     if(!visited[i]) {
       parent_tarjan[i] = -1;
-      tarjan_dfs_bicomp(i);
+      if(block_extraction == EXTRACT_VERTEX_STACK) {
+        tarjan_dfs_vstack(i);
+        vstack_top = 0;
+      } else {
+        tarjan_dfs_bicomp(i);
+      }
     }
   }
+
+  canonical_blocks();
+  blocks_valid = 1;
 }
 
-/* ----------------- Optimal edge addition ------------------ */
+/* Cut-vertex-only DFS: the same lowpoint test, but blocks are only
+ * counted, so there is no edge or vertex stack and no block output. */
+void tarjan_dfs_cut(int u) {
+  visited[u] = 1;
+  disc[u] = low[u] = ++time_dfs;
+  int children = 0;
 
-void identify_leaf_blocks(void) {
-  num_leaf_blocks = 0;
-  memset(is_leaf_block, 0, sizeof(is_leaf_block));
-  
-  for(int b=0; b<num_blocks; b++) {
-    int cut_count = 0;
-    for(int i=0; i<block_size[b]; i++) {
-      int node = block_nodes[b][i];
-      if(is_cut[node]) cut_count++;
+  if(++dfs_depth > dfs_depth_peak) {
+    dfs_depth_peak = dfs_depth;
+    if(dfs_depth == 1) dfs_stack_base = (char *)&children;
+    dfs_stack_deepest = (char *)&children;
+  }
+
+  for(int i=0; i<degree[u]; i++) {
+    int v = neighbors[u][i];
+    if(!visited[v]) {
+      children++;
+      parent_tarjan[v] = u;
+
+      tarjan_dfs_cut(v);
+
+      if(low[v] < low[u]) low[u] = low[v];
+
+      if(low[v] >= disc[u]) {
+        if(parent_tarjan[u] != -1 || children > 1) is_cut[u] = 1;
+        num_blocks++;
+      }
+    } else if(v != parent_tarjan[u] && disc[v] < low[u]) {
+      low[u] = disc[v];
     }
-    
-    if(cut_count == 1) {
-      is_leaf_block[b] = 1;
-      leaf_blocks[num_leaf_blocks++] = b;
+  }
+
+  dfs_depth--;
+}
+
+/* Fills is_cut and num_blocks only; block membership is left invalid
+ * until ensure_blocks() is called. */
+void find_cut_vertices(void) {
+  memset(visited, 0, sizeof(visited));
+  memset(parent_tarjan, -1, sizeof(parent_tarjan));
+  memset(disc, 0, sizeof(disc));
+  memset(low, 0, sizeof(low));
+  memset(is_cut, 0, sizeof(is_cut));
+
+  num_blocks = 0;
+  blocks_valid = 0;
+  time_dfs = 0;
+  stack_peak = 0;
+  stack_overflows = 0;
+  dfs_depth = 0;
+  dfs_depth_peak = 0;
+  dfs_stack_base = dfs_stack_deepest = NULL;
+
+  for(int i=0; i<n_nodes; i++) {
+    if(!visited[i]) {
+      parent_tarjan[i] = -1;
+      tarjan_dfs_cut(i);
     }
   }
 }
 
-int find_non_cut_in_block(int block) {
-  for(int i=0; i<block_size[block]; i++) {
-    int node = block_nodes[block][i];
-    if(!is_cut[node]) return node;
+/* Lazy block builder for callers that need membership */
+void ensure_blocks(void) {
+  if(!blocks_valid) find_biconnected_components();
+}
+
+/* Peak bytes held by the block stack of the last analysis */
+long block_stack_bytes(void) {
+  return (long)stack_peak * (long)(block_extraction == EXTRACT_VERTEX_STACK ?
+                                   sizeof(int) : sizeof(Edge));
+}
+
+/* ----------------- Result set ------------------ */
+
+/* Double-buffered copy of the latest analysis for concurrent queries.
+ * rs_seq counts publications and buffer rs_seq & 1 is the current one.
+ * The writer fills the other buffer, then bumps rs_seq, so it never
+ * touches the buffer readers are directed to. A reader retries only if
+ * a publication lands while it reads, as the buffer it read may then be
+ * the next one to be rewritten. Readers take no locks and write no
+ * shared state. Block ids are published only when asked for, or when
+ * the blocks are already built; otherwise they read as -1. */
+static char rs_cut[2][MAX_NODES];
+static int rs_block[2][MAX_NODES];    /* lowest-numbered block of each node */
+static int rs_nodes[2];
+static unsigned long rs_seq = 0;
+
+/* A publication in pieces: result_publish_begin() picks the buffer to
+ * fill, result_publish_rows() copies the cut flags of nodes lo .. hi-1,
+ * result_publish_block() the ids of block k (blocks go from the highest
+ * k down, so a node keeps its lowest block), and result_publish_end()
+ * makes the buffer current. Single writer. */
+int result_publish_begin(int with_blocks) {
+  if(with_blocks) ensure_blocks();
+  int b = (int)((__atomic_load_n(&rs_seq, __ATOMIC_RELAXED) + 1) & 1);
+  /* Readers still on the previous publication may be reading buffer b;
+   * its increment must be visible before any of the stores below */
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  return b;
+}
+
+void result_publish_rows(int b, int lo, int hi) {
+  for(int i=lo; i<hi; i++) {
+    __atomic_store_n(&rs_cut[b][i], is_cut[i], __ATOMIC_RELAXED);
+    __atomic_store_n(&rs_block[b][i], -1, __ATOMIC_RELAXED);
   }
-  return (block_size[block] > 0) ? block_nodes[block][0] : -1;
 }
 
-void add_optimal_redundant_edges(void) {
-  identify_leaf_blocks();
-  
-  LOG_INFO("Found %d leaf blocks (need %d edges)\n", 
-           num_leaf_blocks, (num_leaf_blocks + 1) / 2);
-  
-  redundant_edges_added = 0;
-  
-  for(int i=0; i<num_leaf_blocks; i+=2) {
-    int block1 = leaf_blocks[i];
-    int block2 = (i+1 < num_leaf_blocks) ? leaf_blocks[i+1] : leaf_blocks[0];
-    
-    int node1 = find_non_cut_in_block(block1);
-    int node2 = find_non_cut_in_block(block2);
-    
-    if(node1 != -1 && node2 != -1 && node1 != node2 && !exists_edge[node1][node2]) {
-      if(degree[node1] < MAX_NEIGHBORS && degree[node2] < MAX_NEIGHBORS) {
-        neighbors[node1][degree[node1]++] = node2;
-        neighbors[node2][degree[node2]++] = node1;
-        exists_edge[node1][node2] = exists_edge[node2][node1] = 1;
-        redundant_edge[node1][node2] = redundant_edge[node2][node1] = 1;
-        redundant_edges_added++;
-      }
+void result_publish_block(int b, int k) {
+  for(int i=0; i<block_size[k]; i++) {
+    __atomic_store_n(&rs_block[b][block_nodes[k][i]], k, __ATOMIC_RELAXED);
+  }
+}
+
+void result_publish_end(int b) {
+  __atomic_store_n(&rs_nodes[b], n_nodes, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&rs_seq, 1, __ATOMIC_RELEASE);
+}
+
+/* Publishes is_cut[] of the current graph, and its blocks if
+ * with_blocks is set (building them if needed) or they are already
+ * valid */
+void result_publish(int with_blocks) {
+  int b = result_publish_begin(with_blocks);
+  result_publish_rows(b, 0, n_nodes);
+  for(int k=blocks_valid ? num_blocks-1 : -1; k>=0; k--) result_publish_block(b, k);
+  result_publish_end(b);
+}
+
+/* Cut status of node v in the latest published analysis (-1 if v is
+ * out of range), and its block id through block (-1 if that
+ * publication carried no blocks). retries, if non-NULL,
+ * counts re-reads caused by concurrent publications. */
+static inline int result_query(int v, int *block, long *retries) {
+  for(;;) {
+    unsigned long s1 = __atomic_load_n(&rs_seq, __ATOMIC_ACQUIRE);
+    int b = (int)(s1 & 1);
+    int n = __atomic_load_n(&rs_nodes[b], __ATOMIC_RELAXED);
+    int cut = v < n ? __atomic_load_n(&rs_cut[b][v], __ATOMIC_RELAXED) : -1;
+    int blk = v < n ? __atomic_load_n(&rs_block[b][v], __ATOMIC_RELAXED) : -1;
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if(__atomic_load_n(&rs_seq, __ATOMIC_RELAXED) == s1) {
+      if(block) *block = blk;
+      return cut;
     }
+    if(retries) (*retries)++;
   }
-  
-  LOG_INFO("Added %d optimal redundant edges\n", redundant_edges_added);
 }
 
-/* ----------------- Compute metrics ------------------ */
+/* ----------------- Large allocations ------------------ */
 
-void compute_network_metrics(void) {
-  /* Count cut vertices */
-  initial_cut_vertices = 0;
-  final_cut_vertices = 0;
-  for(int i=0; i<n_nodes; i++) {
-    if(is_cut[i]) final_cut_vertices++;
+/* Backing for the big per-graph arrays (CSR, analysis state). With huge
+ * pages on, each 2 MB of random adjacency traffic costs one TLB entry
+ * instead of 512. "explicit" needs pages reserved in
+ * /proc/sys/vm/nr_hugepages and falls back to "thp" when none are free. */
+typedef enum { HUGE_OFF = 0, HUGE_THP, HUGE_EXPLICIT } hugepage_mode_t;
+
+static const char *hugepage_names[] = { "off", "thp", "explicit" };
+static hugepage_mode_t hugepage_mode = HUGE_OFF;
+
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+
+static size_t alloc_length(size_t bytes) {
+  if(hugepage_mode == HUGE_OFF) return bytes;
+  return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+/* Mapped length of every live numa_alloc() region, so numa_free()
+ * unmaps what was mapped even if hugepage_mode changed in between. A
+ * plain array: live regions number in the tens and freeing is a munmap
+ * anyway. */
+#define ALLOC_SLOTS 1024
+static void *alloc_ptr[ALLOC_SLOTS];
+static size_t alloc_len[ALLOC_SLOTS];
+static pthread_mutex_t alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void alloc_record(void *p, size_t len) {
+  static int warned = 0;
+  pthread_mutex_lock(&alloc_lock);
+  int i = 0;
+  while(i < ALLOC_SLOTS && alloc_ptr[i]) i++;
+  if(i < ALLOC_SLOTS) {
+    alloc_ptr[i] = p;
+    alloc_len[i] = len;
+  } else if(!warned) {
+    LOG_WARN("More than %d live allocations; lengths no longer tracked\n", ALLOC_SLOTS);
+    warned = 1;
   }
-  
-  /* Compute average and max degree */
-  int sum_degree = 0;
-  max_degree_initial = 0;
-  max_degree_final = 0;
-  
-  for(int i=0; i<n_nodes; i++) {
-    sum_degree += degree[i];
-    if(degree[i] > max_degree_final) max_degree_final = degree[i];
+  pthread_mutex_unlock(&alloc_lock);
+}
+
+/* Recorded length of p, forgetting it; the current mode's rounding of
+ * bytes if p was never recorded */
+static size_t alloc_forget(void *p, size_t bytes) {
+  size_t len = alloc_length(bytes);
+  pthread_mutex_lock(&alloc_lock);
+  for(int i=0; i<ALLOC_SLOTS; i++) {
+    if(alloc_ptr[i] == p) {
+      len = alloc_len[i];
+      alloc_ptr[i] = NULL;
+      break;
+    }
   }
-  
-  avg_degree_final = (double)sum_degree / n_nodes;
-  
-  /* Initial avg degree is calculated from original_edges */
-  avg_degree_initial = (2.0 * original_edges) / n_nodes;
+  pthread_mutex_unlock(&alloc_lock);
+  return len;
 }
 
-/* ----------------- Export ------------------ */
+/* Page-aligned anonymous memory that nothing has touched yet, so its
+ * physical placement is decided by numa_place() rather than malloc.
+ * Like all anonymous mappings it reads as zeroes, which callers may
+ * rely on instead of clearing it (and first-touching it) themselves. */
+void *numa_alloc(size_t bytes) {
+  static int warned = 0;
+  size_t len = alloc_length(bytes);
+  void *p = MAP_FAILED;
 
-void export_dot_graph(const char *fname, int show_redundant) {
-  FILE *f = fopen(fname, "w");
-  if(!f) {
-    LOG_ERR("Failed to open %s\n", fname);
-    return;
-  }
-  
-  fprintf(f, "graph DODAG {\n");
-  fprintf(f, "  layout=sfdp; K=0.5; overlap=prism; splines=true;\n");
-  fprintf(f, "  node [shape=circle,width=0.3,fixedsize=true,fontsize=8];\n");
-  
-  for(int u=0; u<n_nodes; u++) {
-    if(u == 0) {
-      fprintf(f, "  %d [color=blue,style=filled,fillcolor=lightblue];\n", u);
-    } else if(is_cut[u]) {
-      fprintf(f, "  %d [color=red,style=filled,fillcolor=pink];\n", u);
+#ifdef MAP_HUGETLB
+  if(hugepage_mode == HUGE_EXPLICIT) {
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(p == MAP_FAILED && !warned) {
+      LOG_WARN("MAP_HUGETLB failed (no reserved huge pages?), using THP\n");
+      warned = 1;
     }
   }
-  
-  char shown[MAX_NODES][MAX_NEIGHBORS] = {0};
-  
-  for(int u=0; u<n_nodes; u++) {
-    for(int i=0; i<degree[u]; i++) {
-      int v = neighbors[u][i];
-      if(u < v) {
-        int already_shown = 0;
-        for(int j=0; j<MAX_NEIGHBORS; j++) {
-          if(shown[u][j] == v) { already_shown = 1; break; }
-        }
-        
-        if(!already_shown) {
-          if(show_redundant && redundant_edge[u][v]) {
-            fprintf(f, "  %d -- %d [color=\"#00AA00\",penwidth=2.0];\n", u, v);
-          } else {
-            fprintf(f, "  %d -- %d [color=black];\n", u, v);
-          }
-          
-          for(int j=0; j<MAX_NEIGHBORS; j++) {
-            if(shown[u][j] == 0) { shown[u][j] = v; break; }
-          }
-        }
-      }
+#endif
+
+  if(p == MAP_FAILED && hugepage_mode != HUGE_OFF) {
+    /* Over-map and trim so the region starts on a 2 MB boundary */
+    char *raw = mmap(NULL, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(raw != MAP_FAILED) {
+      size_t head = (HUGE_PAGE_SIZE - (uintptr_t)raw % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+      if(head) munmap(raw, head);
+      munmap(raw + head + len, HUGE_PAGE_SIZE - head);
+      p = raw + head;
+#ifdef MADV_HUGEPAGE
+      madvise(p, len, MADV_HUGEPAGE);
+#endif
     }
   }
-  
-  fprintf(f, "}\n");
-  fclose(f);
-  LOG_INFO("Exported %s\n", fname);
-}
 
-void generate_images(void) {
-  LOG_INFO("Generating PNG images...\n");
-  
-  double start = get_time_ms();
-  int ret1 = system("sfdp -Tpng dodag_old.dot -o dodag_old.png 2>/dev/null");
-  int ret2 = system("sfdp -Tpng dodag_final.dot -o dodag_final.png 2>/dev/null");
-  double elapsed = get_time_ms() - start;
-  
-  if(ret1 == 0 && ret2 == 0) {
-    LOG_INFO("SUCCESS: Generated PNG files (%.2f ms)\n", elapsed);
-  } else {
-    LOG_INFO("Install Graphviz: sudo apt-get install graphviz\n");
-    LOG_INFO("Manual: sfdp -Tpng dodag_old.dot -o dodag_old.png\n");
+  if(p == MAP_FAILED) {
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
   }
+  if(p == MAP_FAILED) return NULL;
+  alloc_record(p, len);
+  return p;
 }
 
-void print_statistics(void) {
-  time_t now;
+void numa_free(void *p, size_t bytes) {
+  if(p) munmap(p, alloc_forget(p, bytes));
+}
+
+/* The static graph, Tarjan state and edge stack live in .bss; ask for
+ * transparent huge pages on the 2 MB-aligned interior of each. */
+static void advise_region(void *p, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+  uintptr_t start = ((uintptr_t)p + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+  uintptr_t end = ((uintptr_t)p + bytes) & ~(HUGE_PAGE_SIZE - 1);
+  if(end > start) madvise((void *)start, end - start, MADV_HUGEPAGE);
+#endif
+}
+
+void advise_static_hugepages(void) {
+  if(hugepage_mode == HUGE_OFF) return;
+  advise_region(neighbors, sizeof(neighbors));
+  advise_region(exists_edge, sizeof(exists_edge));
+  advise_region(redundant_edge, sizeof(redundant_edge));
+  advise_region(edge_stack, sizeof(edge_stack));
+  advise_region(block_nodes, sizeof(block_nodes));
+}
+
+/* Resident huge-page memory of this process, from smaps_rollup */
+long anon_hugepages_kb(void) {
+  char line[128];
+  long kb = -1;
+  FILE *f = fopen("/proc/self/smaps_rollup", "r");
+  if(!f) return -1;
+  while(fgets(line, sizeof(line), f)) {
+    if(sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) break;
+  }
+  fclose(f);
+  return kb;
+}
+
+/* ----------------- CSR snapshot ------------------ */
+
+/* Compressed sparse row view of an undirected graph: the neighbours of u
+ * are targets[offsets[u] .. offsets[u+1]). Engines that must scale past
+ * MAX_NODES work on this layout instead of the static neighbor matrix. */
+typedef struct {
+  int n;
+  int m;                /* adjacency entries, i.e. 2 * edges */
+  const int *offsets;   /* n + 1 entries */
+  const int *targets;   /* m entries */
+} CsrGraph;
+
+static int csr_offsets[MAX_NODES + 1];
+static int csr_targets[MAX_NODES * MAX_NEIGHBORS];
+
+/* Rows lo .. hi-1 of the CSR snapshot; rows below lo must be done */
+static void csr_snapshot_rows(int lo, int hi) {
+  if(lo == 0) csr_offsets[0] = 0;
+  for(int u=lo; u<hi; u++) {
+    int pos = csr_offsets[u];
+    for(int i=0; i<degree[u]; i++) csr_targets[pos++] = neighbors[u][i];
+    csr_offsets[u + 1] = pos;
+  }
+}
+
+/* The finished snapshot as a graph */
+static void csr_snapshot(CsrGraph *g) {
+  g->n = n_nodes;
+  g->m = csr_offsets[n_nodes];
+  g->offsets = csr_offsets;
+  g->targets = csr_targets;
+}
+
+/* Snapshots the current static graph into CSR form */
+void csr_from_graph(CsrGraph *g) {
+  csr_snapshot_rows(0, n_nodes);
+  csr_snapshot(g);
+}
+
+/* ----------------- External-memory mode ------------------ */
+
+/* On-disk CSR: header, then offsets[n+1], then targets[m], all int32 and
+ * grouped by source node, so the adjacency of consecutive nodes lies in
+ * consecutive file blocks. */
+#define CSR_FILE_MAGIC 0x47525343 /* "CSRG" */
+#define EXT_BLOCK_SHIFT 20        /* 1 MB residency blocks */
+
+typedef struct {
+  int magic;
+  int n;
+  int m;
+  int reserved;
+} CsrFileHeader;
+
+/* Residency bookkeeping for a memory-mapped adjacency file. The analysis
+ * marks each block it reads; once capacity blocks are resident the oldest
+ * one is dropped with MADV_DONTNEED (FIFO ring), which caps the resident
+ * adjacency at the edge budget. */
+typedef struct {
+  char *base;
+  size_t length;
+  size_t adjacency;        /* file offset of the first target */
+  int capacity;
+  char *resident;
+  int *ring;
+  int ring_head;
+  int num_resident;
+  long bytes_faulted;
+  long entries_read;
+  long evictions;
+} ExtWindow;
+
+/* Sentinel for "not visited"; disc starts at 1 */
+#define EXT_UNVISITED 0
+
+/* Length of block b; the file's last block may be partial */
+static inline size_t ext_block_len(const ExtWindow *w, int b) {
+  size_t start = (size_t)b << EXT_BLOCK_SHIFT;
+  size_t len = 1UL << EXT_BLOCK_SHIFT;
+  return start + len > w->length ? w->length - start : len;
+}
+
+static inline void ext_touch(ExtWindow *w, const int *p) {
+  int b = (int)(((const char *)p - w->base) >> EXT_BLOCK_SHIFT);
+  w->entries_read++;
+  if(w->resident[b]) return;
+
+  if(w->num_resident == w->capacity) {
+    int r = w->ring[w->ring_head];
+    madvise(w->base + ((size_t)r << EXT_BLOCK_SHIFT), ext_block_len(w, r), MADV_DONTNEED);
+    w->resident[r] = 0;
+    w->ring[w->ring_head] = b;
+    w->ring_head = (w->ring_head + 1) % w->capacity;
+    w->evictions++;
+  } else {
+    w->ring[w->num_resident++] = b;
+  }
+
+  /* Only the adjacency part counts; offsets are read in separately */
+  size_t start = (size_t)b << EXT_BLOCK_SHIFT, len = ext_block_len(w, b);
+  if(start + len <= w->adjacency) len = 0;
+  else if(start < w->adjacency) len -= w->adjacency - start;
+  w->resident[b] = 1;
+  w->bytes_faulted += (long)len;
+}
+
+/* Requests disc[] and offsets[] of the neighbours u's frame examines
+ * next. On the first step of a frame entries c+1 .. c+D are requested at
+ * once, since their ids arrived with the cache line just loaded; after
+ * that one entry per step keeps the window D ahead of the cursor. */
+static inline void csr_prefetch_neighbors(const CsrGraph *g, const int *cdisc,
+                                          int c, int end, int frame_start) {
+  int from = frame_start ? c + 1 : c + prefetch_distance;
+  int to = c + prefetch_distance;
+  if(to >= end) to = end - 1;
+  for(int k=from; k<=to; k++) {
+    int w = g->targets[k];
+    __builtin_prefetch(&cdisc[w]);
+    __builtin_prefetch(&g->offsets[w]);
+  }
+}
+
+/* Iterative Tarjan lowpoint over a CSR graph, cut vertices only. No
+ * recursion and no edge stack, so memory is five ints per node. When
+ * win is non-NULL every adjacency read goes through ext_touch(). With
+ * prefetch_distance > 0 the walk prefetches neighbour state ahead of
+ * use and the first adjacency line of every frame it pushes; not under
+ * a window, where the look-ahead would read targets behind its back.
+ * Blocks are counted into *blocks when it is non-NULL. */
+int csr_cut_blocks(const CsrGraph *g, char *cut, ExtWindow *win, int *blocks) {
+  int n = g->n;
+  size_t bytes = sizeof(int) * (size_t)n;
+  int *cdisc = numa_alloc(bytes);
+  int *clow = numa_alloc(bytes);
+  int *cparent = numa_alloc(bytes);
+  int *cursor = numa_alloc(bytes);
+  int *stack = numa_alloc(bytes);
+  int count = 0;
+
+  if(!cdisc || !clow || !cparent || !cursor || !stack) {
+    LOG_ERR("Out of memory for %d-node analysis\n", n);
+    count = -1;
+    goto out;
+  }
+
+  memset(cut, 0, n);
+  int t = 0, nblocks = 0;
+  int prefetch = win ? 0 : prefetch_distance;
+
+  for(int r=0; r<n; r++) {
+    if(cdisc[r] != EXT_UNVISITED) continue;
+
+    int sp = 0, root_children = 0;
+    cdisc[r] = clow[r] = ++t;
+    cparent[r] = -1;
+    cursor[r] = g->offsets[r];
+    stack[sp++] = r;
+
+    while(sp > 0) {
+      int u = stack[sp - 1];
+
+      int end = g->offsets[u + 1];
+      if(cursor[u] < end) {
+        int c = cursor[u]++;
+        const int *p = &g->targets[c];
+        if(win) ext_touch(win, p);
+        if(prefetch > 0) {
+          csr_prefetch_neighbors(g, cdisc, c, end, c == g->offsets[u]);
+        }
+        int v = *p;
+
+        if(cdisc[v] == EXT_UNVISITED) {
+          cparent[v] = u;
+          cdisc[v] = clow[v] = ++t;
+          cursor[v] = g->offsets[v];
+          if(prefetch > 0) __builtin_prefetch(&g->targets[cursor[v]]);
+          stack[sp++] = v;
+          if(u == r) root_children++;
+        } else if(v != cparent[u] && cdisc[v] < clow[u]) {
+          clow[u] = cdisc[v];
+        }
+      } else {
+        sp--;
+        int p = cparent[u];
+        if(p >= 0) {
+          if(clow[u] < clow[p]) clow[p] = clow[u];
+          if(clow[u] >= cdisc[p]) {
+            nblocks++;
+            if(p != r) cut[p] = 1;
+          }
+        }
+      }
+    }
+
+    if(root_children > 1) cut[r] = 1;
+  }
+
+  for(int i=0; i<n; i++) if(cut[i]) count++;
+  if(blocks) *blocks = nblocks;
+
+out:
+  numa_free(cdisc, bytes);
+  numa_free(clow, bytes);
+  numa_free(cparent, bytes);
+  numa_free(cursor, bytes);
+  numa_free(stack, bytes);
+  return count;
+}
+
+int csr_cut_vertices(const CsrGraph *g, char *cut, ExtWindow *win) {
+  return csr_cut_blocks(g, cut, win, NULL);
+}
+
+/* Writes g in the on-disk CSR format */
+int csr_write_file(const char *fname, const CsrGraph *g) {
+  FILE *f = fopen(fname, "wb");
+  if(!f) {
+    LOG_ERR("Failed to open %s\n", fname);
+    return -1;
+  }
+
+  CsrFileHeader h = { CSR_FILE_MAGIC, g->n, g->m, 0 };
+  int ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+           fwrite(g->offsets, sizeof(int), g->n + 1, f) == (size_t)(g->n + 1) &&
+           fwrite(g->targets, sizeof(int), g->m, f) == (size_t)g->m;
+  fclose(f);
+
+  if(!ok) {
+    LOG_ERR("Short write on %s\n", fname);
+    return -1;
+  }
+  LOG_INFO("Exported %s (%d nodes, %d adjacency entries)\n", fname, g->n, g->m);
+  return 0;
+}
+
+/* Edges of the synthetic external graph are a pure function of the node
+ * id (random tree backbone plus one cross link on about half of the
+ * nodes), so the file can be written in two streaming passes without
+ * ever holding the edge list in memory. Both links stay within a window
+ * of nearby ids, like a deployment numbered by site. */
+#define EXT_PARENT_SPAN 256
+#define SCATTER_MULT 1000003ULL
+
+/* When set, node ids are scattered by a multiplicative bijection so the
+ * same graph is traversed in random memory order (TLB stress). */
+static int synthetic_scatter = 0;
+
+static inline int synthetic_id(int x, int n) {
+  if(!synthetic_scatter || n % SCATTER_MULT == 0) return x;
+  return (int)((unsigned long long)x * SCATTER_MULT % (unsigned long long)n);
+}
+
+static void ext_synthetic_edges(int i, int *p, int *c) {
+  int pspan = i < EXT_PARENT_SPAN ? i : EXT_PARENT_SPAN;
+  *p = i - 1 - (int)(hash_u32((unsigned int)i) % (unsigned int)pspan);
+  *c = -1;
+  if(i > 1 && (hash_u32((unsigned int)i ^ 0x9e3779b9U) & 1)) {
+    int span = i < 20 ? i : 20;
+    int j = i - 1 - (int)(hash_u32((unsigned int)i * 31U) % (unsigned int)span);
+    if(j != *p) *c = j;
+  }
+}
+
+/* Pass 1 of synthetic generation: fills offs[0..n] and returns m */
+int csr_synthetic_offsets(int n, int *offs) {
+  memset(offs, 0, sizeof(int) * ((size_t)n + 1));
+  for(int i=1; i<n; i++) {
+    int p, c;
+    ext_synthetic_edges(i, &p, &c);
+    int si = synthetic_id(i, n);
+    offs[si + 1]++; offs[synthetic_id(p, n) + 1]++;
+    if(c >= 0) { offs[si + 1]++; offs[synthetic_id(c, n) + 1]++; }
+  }
+  for(int i=0; i<n; i++) offs[i + 1] += offs[i];
+  return offs[n];
+}
+
+/* Pass 2: scatters targets, advancing cursor (a copy of the offsets) */
+void csr_synthetic_targets(int n, int *cursor, int *tgts) {
+  for(int i=1; i<n; i++) {
+    int p, c;
+    ext_synthetic_edges(i, &p, &c);
+    int si = synthetic_id(i, n);
+    p = synthetic_id(p, n);
+    tgts[cursor[si]++] = p; tgts[cursor[p]++] = si;
+    if(c >= 0) {
+      c = synthetic_id(c, n);
+      tgts[cursor[si]++] = c; tgts[cursor[c]++] = si;
+    }
+  }
+}
+
+int csr_generate_file(const char *fname, int n) {
+  int *offs = malloc(sizeof(int) * ((size_t)n + 1));
+  if(!offs) {
+    LOG_ERR("Out of memory for %d-node generation\n", n);
+    return -1;
+  }
+
+  int m = csr_synthetic_offsets(n, offs);
+
+  size_t length = sizeof(CsrFileHeader) + sizeof(int) * ((size_t)n + 1 + m);
+  int fd = open(fname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0 || ftruncate(fd, (off_t)length) != 0) {
+    LOG_ERR("Failed to create %s\n", fname);
+    if(fd >= 0) close(fd);
+    free(offs);
+    return -1;
+  }
+  char *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if(base == MAP_FAILED) {
+    LOG_ERR("Failed to map %s\n", fname);
+    free(offs);
+    return -1;
+  }
+
+  CsrFileHeader h = { CSR_FILE_MAGIC, n, m, 0 };
+  memcpy(base, &h, sizeof(h));
+  int *file_offs = (int *)(base + sizeof(h));
+  int *file_tgts = file_offs + n + 1;
+  memcpy(file_offs, offs, sizeof(int) * ((size_t)n + 1));
+
+  csr_synthetic_targets(n, offs, file_tgts);
+
+  munmap(base, length);
+  free(offs);
+  LOG_INFO("Generated %s: %d nodes, %d edges (%.1f MB)\n",
+           fname, n, m / 2, length / (1024.0 * 1024.0));
+  return 0;
+}
+
+/* Checks that offsets start at 0, never decrease and end at m, and that
+ * every target is a node id, so a truncated or corrupt file cannot send
+ * the DFS out of bounds. Streams through the arrays one residency block
+ * at a time and drops each block once read, so the check stays within
+ * any budget the external pass accepts. Returns 0 if the arrays are
+ * sound. */
+static int csr_validate_mapping(const char *fname, char *base, size_t length,
+                                const CsrFileHeader *h) {
+  const int *a = (const int *)(base + sizeof(*h));
+  const size_t block = 1UL << EXT_BLOCK_SHIFT;
+  long noffs = (long)h->n + 1, total = noffs + h->m;
+  int prev = 0;
+
+  for(long i=0; i<total; ) {
+    size_t at = sizeof(*h) + sizeof(int) * (size_t)i;
+    size_t first = at / block * block;
+    long stop = (long)((first + block - sizeof(*h)) / sizeof(int));
+    if(stop > total) stop = total;
+
+    for(; i<stop; i++) {
+      int x = a[i];
+      if(i < noffs) {
+        if((i == 0 && x != 0) || x < prev || x > h->m) {
+          LOG_ERR("%s: bad offset %d for node %ld\n", fname, x, i);
+          return -1;
+        }
+        prev = x;
+      } else if(x < 0 || x >= h->n) {
+        LOG_ERR("%s: target %d out of range at entry %ld\n", fname, x, i - noffs);
+        return -1;
+      }
+    }
+    madvise(base + first, first + block > length ? length - first : block, MADV_DONTNEED);
+  }
+  if(prev != h->m) {
+    LOG_ERR("%s: offsets end at %d, expected %d\n", fname, prev, h->m);
+    return -1;
+  }
+  return 0;
+}
+
+/* Maps a CSR graph file read-only and checks its header and arrays.
+ * Returns the mapping (length bytes, header in h), or NULL. */
+char *csr_map_file(const char *fname, CsrFileHeader *h, size_t *length) {
+  int fd = open(fname, O_RDONLY);
+  struct stat st;
+  if(fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CsrFileHeader)) {
+    LOG_ERR("Failed to open %s\n", fname);
+    if(fd >= 0) close(fd);
+    return NULL;
+  }
+  *length = (size_t)st.st_size;
+  char *base = mmap(NULL, *length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(base == MAP_FAILED) {
+    LOG_ERR("Failed to map %s\n", fname);
+    return NULL;
+  }
+
+  memcpy(h, base, sizeof(*h));
+  if(h->magic != CSR_FILE_MAGIC || h->n <= 0 || h->m < 0 ||
+     sizeof(*h) + sizeof(int) * ((size_t)h->n + 1 + h->m) > *length) {
+    LOG_ERR("%s is not a CSR graph file\n", fname);
+    munmap(base, *length);
+    return NULL;
+  }
+  if(csr_validate_mapping(fname, base, *length, h) != 0) {
+    munmap(base, *length);
+    return NULL;
+  }
+  return base;
+}
+
+/* Semi-external articulation points: node state (offsets plus five ints
+ * per node) stays in RAM, the adjacency is read from a memory-mapped file
+ * whose resident part is capped at what is left of budget_mb. */
+int run_external_analysis(const char *fname, long budget_mb) {
+  CsrFileHeader h;
+  size_t length;
+  char *base = csr_map_file(fname, &h, &length);
+  if(!base) return -1;
+
+  long budget = budget_mb * 1024L * 1024L;
+  long node_state = (long)h.n * (6 * sizeof(int) + 1) + sizeof(int);
+  long window = budget - node_state;
+  if(window < (1L << EXT_BLOCK_SHIFT)) {
+    LOG_ERR("Budget %ld MB too small: node state alone needs %.1f MB\n",
+            budget_mb, node_state / (1024.0 * 1024.0));
+    munmap(base, length);
+    return -1;
+  }
+
+  int nblocks = (int)((length >> EXT_BLOCK_SHIFT) + 1);
+  ExtWindow win;
+  memset(&win, 0, sizeof(win));
+  win.base = base;
+  win.length = length;
+  win.adjacency = sizeof(h) + sizeof(int) * ((size_t)h.n + 1);
+  win.capacity = (int)(window >> EXT_BLOCK_SHIFT);
+  if(win.capacity > nblocks) win.capacity = nblocks;
+  win.resident = calloc(nblocks, 1);
+  win.ring = malloc(sizeof(int) * win.capacity);
+
+  /* Offsets are node state: copy them in, then release their pages */
+  int *offs = malloc(sizeof(int) * ((size_t)h.n + 1));
+  char *cut = malloc(h.n);
+  int count = -1;
+
+  if(win.resident && win.ring && offs && cut) {
+    memcpy(offs, base + sizeof(h), sizeof(int) * ((size_t)h.n + 1));
+    win.bytes_faulted += sizeof(int) * ((long)h.n + 1);
+    madvise(base, sizeof(h) + sizeof(int) * ((size_t)h.n + 1), MADV_DONTNEED);
+
+    CsrGraph g = { h.n, h.m, offs, (const int *)(base + sizeof(h)) + h.n + 1 };
+    /* DFS order jumps across the file; kernel readahead would only
+     * inflate the resident set past the window */
+    madvise(base, length, MADV_RANDOM);
+
+    LOG_INFO("External analysis of %s: %d nodes, %d edges, budget %ld MB "
+             "(node state %.1f MB, edge window %.1f MB)\n",
+             fname, h.n, h.m / 2, budget_mb,
+             node_state / (1024.0 * 1024.0), window / (1024.0 * 1024.0));
+
+    if(prefetch_distance > 0) LOG_INFO("Prefetch is off under the residency window\n");
+    double start = get_time_ms();
+    count = csr_cut_vertices(&g, cut, &win);
+    double elapsed = get_time_ms() - start;
+
+    if(count >= 0) {
+      double secs = elapsed > 0 ? elapsed / 1000.0 : 1e-9;
+      LOG_INFO("External: %d cut vertices in %.2f ms\n", count, elapsed);
+      LOG_INFO("External I/O: %.1f MB mapped in, %ld window evictions, "
+               "%.1f MB/s, %.2f M adjacency entries/s\n",
+               win.bytes_faulted / (1024.0 * 1024.0), win.evictions,
+               win.bytes_faulted / (1024.0 * 1024.0) / secs,
+               win.entries_read / 1e6 / secs);
+      LOG_INFO("Peak RSS: %ld KB\n", peak_rss_kb());
+    }
+  } else {
+    LOG_ERR("Out of memory for external analysis\n");
+  }
+
+  free(win.resident);
+  free(win.ring);
+  free(offs);
+  free(cut);
+  munmap(base, length);
+  return count;
+}
+
+/* ----------------- What-if overlay ------------------ */
+
+/* A base CSR graph plus a small list of proposed links, analysed as one
+ * graph without copying or modifying the base. Each link is stored in
+ * both directions in delta[], sorted by source, so a vertex's proposed
+ * links are one contiguous run; an open-addressed table maps each
+ * source to the start of its run. */
+typedef struct {
+  const CsrGraph *base;
+  int k;              /* delta entries, 2 per link */
+  Edge *delta;
+  int mask;           /* table size - 1, a power of two */
+  int *slot_node;     /* -1 for an empty slot */
+  int *slot_first;
+} OverlayGraph;
+
+static int compare_edges(const void *a, const void *b) {
+  const Edge *ea = a, *eb = b;
+  if(ea->u != eb->u) return ea->u - eb->u;
+  return ea->v - eb->v;
+}
+
+/* Builds an overlay of links[0..nlinks) on base. Links with an endpoint
+ * outside the base or joining a node to itself are left out. Returns -1
+ * when out of memory. */
+int overlay_build(OverlayGraph *o, const CsrGraph *base, const Edge *links, int nlinks) {
+  int size = 4;
+  while(size < 4 * nlinks) size <<= 1;
+
+  o->base = base;
+  o->k = 0;
+  o->mask = size - 1;
+  o->delta = malloc(sizeof(Edge) * (size_t)(2 * nlinks + 1));
+  o->slot_node = malloc(sizeof(int) * (size_t)size);
+  o->slot_first = malloc(sizeof(int) * (size_t)size);
+  if(!o->delta || !o->slot_node || !o->slot_first) return -1;
+
+  for(int i=0; i<nlinks; i++) {
+    int u = links[i].u, v = links[i].v;
+    if(u < 0 || v < 0 || u >= base->n || v >= base->n || u == v) continue;
+    o->delta[o->k].u = u; o->delta[o->k].v = v; o->k++;
+    o->delta[o->k].u = v; o->delta[o->k].v = u; o->k++;
+  }
+  qsort(o->delta, o->k, sizeof(Edge), compare_edges);
+
+  for(int i=0; i<size; i++) o->slot_node[i] = -1;
+  for(int j=0; j<o->k; j++) {
+    int u = o->delta[j].u;
+    if(j > 0 && o->delta[j - 1].u == u) continue;
+    int h = hash_u32((unsigned int)u) & o->mask;
+    while(o->slot_node[h] != -1) h = (h + 1) & o->mask;
+    o->slot_node[h] = u;
+    o->slot_first[h] = j;
+  }
+  return 0;
+}
+
+void overlay_free(OverlayGraph *o) {
+  free(o->delta);
+  free(o->slot_node);
+  free(o->slot_first);
+  o->delta = NULL;
+  o->slot_node = o->slot_first = NULL;
+}
+
+/* Start of u's run in delta[], or k when u has no proposed links */
+static inline int overlay_first(const OverlayGraph *o, int u) {
+  int h = hash_u32((unsigned int)u) & o->mask;
+  while(o->slot_node[h] != -1) {
+    if(o->slot_node[h] == u) return o->slot_first[h];
+    h = (h + 1) & o->mask;
+  }
+  return o->k;
+}
+
+/* csr_cut_vertices() over base + delta. cursor[u] walks u's base
+ * entries and then, encoded as -(j + 1), its delta run starting at j. */
+int overlay_cut_vertices(const OverlayGraph *o, char *cut) {
+  const CsrGraph *g = o->base;
+  int n = g->n;
+  size_t bytes = sizeof(int) * (size_t)n;
+  int *cdisc = numa_alloc(bytes);
+  int *clow = numa_alloc(bytes);
+  int *cparent = numa_alloc(bytes);
+  int *cursor = numa_alloc(bytes);
+  int *stack = numa_alloc(bytes);
+  int count = 0;
+
+  if(!cdisc || !clow || !cparent || !cursor || !stack) {
+    LOG_ERR("Out of memory for %d-node overlay analysis\n", n);
+    count = -1;
+    goto out;
+  }
+
+  memset(cut, 0, n);
+  int t = 0;
+
+  for(int r=0; r<n; r++) {
+    if(cdisc[r] != EXT_UNVISITED) continue;
+
+    int sp = 0, root_children = 0;
+    cdisc[r] = clow[r] = ++t;
+    cparent[r] = -1;
+    cursor[r] = g->offsets[r];
+    stack[sp++] = r;
+
+    while(sp > 0) {
+      int u = stack[sp - 1];
+      int v = -1;
+      int c = cursor[u];
+
+      if(c >= 0 && c < g->offsets[u + 1]) {
+        v = g->targets[c];
+        cursor[u] = c + 1;
+      } else {
+        if(c >= 0) c = -(overlay_first(o, u) + 1);
+        int j = -c - 1;
+        if(j < o->k && o->delta[j].u == u) {
+          v = o->delta[j].v;
+          c--;
+        }
+        cursor[u] = c;
+      }
+
+      if(v != -1) {
+        if(cdisc[v] == EXT_UNVISITED) {
+          cparent[v] = u;
+          cdisc[v] = clow[v] = ++t;
+          cursor[v] = g->offsets[v];
+          stack[sp++] = v;
+          if(u == r) root_children++;
+        } else if(v != cparent[u] && cdisc[v] < clow[u]) {
+          clow[u] = cdisc[v];
+        }
+      } else {
+        sp--;
+        int p = cparent[u];
+        if(p >= 0) {
+          if(clow[u] < clow[p]) clow[p] = clow[u];
+          if(p != r && clow[u] >= cdisc[p]) cut[p] = 1;
+        }
+      }
+    }
+
+    if(root_children > 1) cut[r] = 1;
+  }
+
+  for(int i=0; i<n; i++) if(cut[i]) count++;
+
+out:
+  numa_free(cdisc, bytes);
+  numa_free(clow, bytes);
+  numa_free(cparent, bytes);
+  numa_free(cursor, bytes);
+  numa_free(stack, bytes);
+  return count;
+}
+
+/* Writes base + delta as one CSR into offs (n + 1 entries) and tgts
+ * (base->m + k entries). Returns the number of adjacency entries. */
+int overlay_flatten(const OverlayGraph *o, int *offs, int *tgts) {
+  const CsrGraph *g = o->base;
+  int pos = 0;
+  for(int u=0; u<g->n; u++) {
+    offs[u] = pos;
+    int len = g->offsets[u + 1] - g->offsets[u];
+    memcpy(&tgts[pos], &g->targets[g->offsets[u]], sizeof(int) * (size_t)len);
+    pos += len;
+    for(int j=overlay_first(o, u); j<o->k && o->delta[j].u == u; j++) {
+      tgts[pos++] = o->delta[j].v;
+    }
+  }
+  offs[g->n] = pos;
+  return pos;
+}
+
+/* Cut vertices left if links were added to base; base is not modified.
+ * Returns -1 when out of memory. */
+int whatif_cut_vertices(const CsrGraph *base, const Edge *links, int nlinks) {
+  OverlayGraph o;
+  char *cut = malloc(base->n);
+  int count = -1;
+
+  if(overlay_build(&o, base, links, nlinks) == 0 && cut) {
+    count = overlay_cut_vertices(&o, cut);
+  }
+
+  overlay_free(&o);
+  free(cut);
+  return count;
+}
+
+/* ----------------- Chain decomposition engine ------------------ */
+
+/* A vertex is visited either as the start of a chain or by a chain walk;
+ * only the latter covers the tree edge to its parent. */
+#define CHAIN_START 1
+#define CHAIN_COVERED 2
+
+/* Schmidt's chain decomposition ("A simple test on 2-vertex- and
+ * 2-edge-connectivity", 2013). One DFS fixes a preorder; then, for each
+ * vertex v in preorder and each back edge v->w into v's subtree, the
+ * walk w, parent(w), ... up to the first already-visited vertex is one
+ * chain. Tree edges left uncovered are bridges, and v is a cut vertex iff
+ * it is a non-leaf end of a bridge or starts a cycle chain other than
+ * the first chain of its component. No lowpoints and no edge stack: the
+ * second phase only reads parent[] and sweeps the adjacency in order. */
+typedef enum { ENGINE_TARJAN = 0, ENGINE_CHAIN } engine_t;
+
+static const char *engine_names[] = { "tarjan", "chain" };
+static engine_t analysis_engine = ENGINE_TARJAN;
+
+typedef struct {
+  int cut_vertices;
+  int bridges;
+  int chains;
+  int cycles;        /* cycle chains; one per non-bridge block */
+  int components;
+  int biconnected;   /* certificate: connected, no bridge, single cycle */
+} ChainResult;
+
+int chain_cut_vertices(const CsrGraph *g, char *cut, ChainResult *res) {
+  int n = g->n;
+  size_t bytes = sizeof(int) * (size_t)n;
+  int *dfi = numa_alloc(bytes);       /* preorder index + 1, 0 = unseen */
+  int *cparent = numa_alloc(bytes);
+  int *order = numa_alloc(bytes);     /* vertices in preorder */
+  int *cursor = numa_alloc(bytes);
+  int *stack = numa_alloc(bytes);
+  char *seen = numa_alloc(n);         /* CHAIN_START or CHAIN_COVERED */
+  int status = 0;
+
+  memset(res, 0, sizeof(*res));
+  if(!dfi || !cparent || !order || !cursor || !stack || !seen) {
+    LOG_ERR("Out of memory for %d-node analysis\n", n);
+    status = -1;
+    goto out;
+  }
+  memset(cut, 0, n);
+
+  /* Phase 1: DFS preorder and tree */
+  int t = 0;
+  for(int r=0; r<n; r++) {
+    if(dfi[r]) continue;
+    int sp = 0;
+    res->components++;
+    cparent[r] = -1;
+    dfi[r] = ++t;
+    order[t - 1] = r;
+    cursor[r] = g->offsets[r];
+    stack[sp++] = r;
+
+    while(sp > 0) {
+      int u = stack[sp - 1];
+      if(cursor[u] < g->offsets[u + 1]) {
+        int v = g->targets[cursor[u]++];
+        if(!dfi[v]) {
+          cparent[v] = u;
+          dfi[v] = ++t;
+          order[t - 1] = v;
+          cursor[v] = g->offsets[v];
+          stack[sp++] = v;
+        }
+      } else {
+        sp--;
+      }
+    }
+  }
+
+  /* Phase 2: chains in preorder of their start vertex. Preorder lists
+   * each DFS tree contiguously, so a root resets the per-component count
+   * and the first chain seen after it is that component's C1. */
+  int component_chains = 0;
+  for(int k=0; k<n; k++) {
+    int v = order[k];
+    if(cparent[v] == -1) component_chains = 0;
+
+    for(int i=g->offsets[v]; i<g->offsets[v + 1]; i++) {
+      int w = g->targets[i];
+      if(dfi[w] <= dfi[v] || cparent[w] == v) continue;
+
+      /* Back edge v->w: walk up until a visited vertex */
+      if(!seen[v]) seen[v] = CHAIN_START;
+      int x = w;
+      while(!seen[x]) {
+        seen[x] = CHAIN_COVERED;
+        x = cparent[x];
+      }
+      res->chains++;
+
+      if(x == v) {
+        res->cycles++;
+        if(component_chains > 0) cut[v] = 1;
+      }
+      component_chains++;
+    }
+  }
+
+  /* Phase 3: uncovered tree edges are bridges */
+  for(int x=0; x<n; x++) {
+    int p = cparent[x];
+    if(p < 0 || seen[x] == CHAIN_COVERED) continue;
+    res->bridges++;
+    if(g->offsets[p + 1] - g->offsets[p] >= 2) cut[p] = 1;
+    if(g->offsets[x + 1] - g->offsets[x] >= 2) cut[x] = 1;
+  }
+
+  for(int i=0; i<n; i++) if(cut[i]) res->cut_vertices++;
+  res->biconnected = n >= 3 && res->components == 1 &&
+                     res->bridges == 0 && res->cycles == 1;
+  status = res->cut_vertices;
+
+out:
+  numa_free(dfi, bytes);
+  numa_free(cparent, bytes);
+  numa_free(order, bytes);
+  numa_free(cursor, bytes);
+  numa_free(stack, bytes);
+  numa_free(seen, n);
+  return status;
+}
+
+/* ----------------- Threads and NUMA placement ------------------ */
+
+/* Worker pool shared by all parallel engines. Each call runs fn on
+ * nthreads threads; thread tid is pinned according to pin_policy so that
+ * pages it first-touches stay on its socket. */
+typedef void (*worker_fn)(int tid, int nthreads, void *arg);
+
+/* Sets up shared state (barriers, per-thread layouts) for a team of
+ * nthreads before its workers start */
+typedef void (*prepare_fn)(void *arg, int nthreads);
+
+typedef enum { PIN_NONE = 0, PIN_COMPACT, PIN_SCATTER } pin_policy_t;
+typedef enum { PLACE_DEFAULT = 0, PLACE_INTERLEAVE, PLACE_LOCAL } placement_t;
+
+static const char *pin_names[] = { "none", "compact", "scatter" };
+static const char *placement_names[] = { "default", "interleave", "local" };
+
+static int num_threads = 1;
+static int force_parallel = 0;     /* ignore the small-input thresholds */
+static pin_policy_t pin_policy = PIN_NONE;
+
+#define MAX_NUMA_NODES 64
+#define MAX_CPUS 1024
+
+static int numa_nodes = 0;
+static int cpu_order[MAX_CPUS];
+static int num_cpus = 0;
+
+/* Parses a sysfs cpulist such as "0-3,8-11" into out[], returns count */
+static int parse_cpulist(const char *s, int *out, int max) {
+  int count = 0;
+  while(*s && count < max) {
+    char *end;
+    int a = (int)strtol(s, &end, 10);
+    if(end == s) break;
+    int b = a;
+    if(*end == '-') b = (int)strtol(end + 1, &end, 10);
+    for(int c=a; c<=b && count < max; c++) out[count++] = c;
+    s = (*end == ',') ? end + 1 : end;
+  }
+  return count;
+}
+
+/* Builds cpu_order[] for the active pin policy: compact fills one socket
+ * before the next, scatter deals CPUs round-robin across sockets. */
+static void detect_topology(void) {
+  static int node_cpus[MAX_NUMA_NODES][MAX_CPUS];
+  static int node_ncpus[MAX_NUMA_NODES];
+  char path[96], buf[4096];
+
+  if(num_cpus > 0) return;
+
+  numa_nodes = 0;
+  for(int nd=0; nd<MAX_NUMA_NODES; nd++) {
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", nd);
+    FILE *f = fopen(path, "r");
+    if(!f) break;
+    node_ncpus[nd] = fgets(buf, sizeof(buf), f) ?
+      parse_cpulist(buf, node_cpus[nd], MAX_CPUS) : 0;
+    fclose(f);
+    numa_nodes++;
+  }
+
+  if(numa_nodes == 0) {
+    numa_nodes = 1;
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    node_ncpus[0] = n < 1 ? 1 : n > MAX_CPUS ? MAX_CPUS : (int)n;
+    for(int c=0; c<node_ncpus[0]; c++) node_cpus[0][c] = c;
+  }
+
+  if(pin_policy == PIN_SCATTER) {
+    for(int i=0, more=1; more; i++) {
+      more = 0;
+      for(int nd=0; nd<numa_nodes; nd++) {
+        if(i < node_ncpus[nd] && num_cpus < MAX_CPUS) {
+          cpu_order[num_cpus++] = node_cpus[nd][i];
+          more = 1;
+        }
+      }
+    }
+  } else {
+    for(int nd=0; nd<numa_nodes; nd++) {
+      for(int i=0; i<node_ncpus[nd] && num_cpus<MAX_CPUS; i++) {
+        cpu_order[num_cpus++] = node_cpus[nd][i];
+      }
+    }
+  }
+  if(num_cpus == 0) cpu_order[num_cpus++] = 0;
+}
+
+typedef struct {
+  worker_fn fn;
+  void *arg;
+  int tid;
+  int nthreads;
+  int *gate;               /* set once the team is final */
+} WorkerStart;
+
+static void pin_current_thread(int tid) {
+  if(pin_policy == PIN_NONE) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu_order[tid % num_cpus], &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void *worker_main(void *p) {
+  WorkerStart *w = p;
+  while(!__atomic_load_n(w->gate, __ATOMIC_ACQUIRE)) sched_yield();
+  pin_current_thread(w->tid);
+  w->fn(w->tid, w->nthreads, w->arg);
+  return NULL;
+}
+
+/* Runs fn on a team of up to nthreads threads and returns the team
+ * size. Workers wait at a gate until every thread that could be
+ * created exists; if some could not, the team shrinks and the others
+ * are renumbered, so workers that meet at barriers never wait for a
+ * thread that was not started. prepare, if given, sees the final team
+ * size before the gate opens. */
+int run_parallel_team(int nthreads, worker_fn fn, void *arg, prepare_fn prepare) {
+  pthread_t th[nthreads];
+  WorkerStart ws[nthreads];
+  int started[nthreads];
+  int gate = 0, team = 0;
+
+  detect_topology();
+  for(int t=0; t<nthreads; t++) {
+    ws[t].fn = fn;
+    ws[t].arg = arg;
+    ws[t].gate = &gate;
+    started[t] = nthreads > 1 && pthread_create(&th[t], NULL, worker_main, &ws[t]) == 0;
+    if(started[t]) ws[t].tid = team++;
+  }
+  if(team == 0) {
+    /* Inline on the calling thread, which is left unpinned */
+    if(prepare) prepare(arg, 1);
+    fn(0, 1, arg);
+    return 1;
+  }
+  if(team < nthreads) LOG_WARN("Started %d of %d threads\n", team, nthreads);
+
+  for(int t=0; t<nthreads; t++) ws[t].nthreads = team;
+  if(prepare) prepare(arg, team);
+  __atomic_store_n(&gate, 1, __ATOMIC_RELEASE);
+  for(int t=0; t<nthreads; t++) if(started[t]) pthread_join(th[t], NULL);
+  return team;
+}
+
+int run_parallel(int nthreads, worker_fn fn, void *arg) {
+  return run_parallel_team(nthreads, fn, arg, NULL);
+}
+
+/* Contiguous share [lo, hi) of n items for thread tid */
+static inline void thread_range(int tid, int nthreads, long n, long *lo, long *hi) {
+  *lo = n * tid / nthreads;
+  *hi = n * (tid + 1) / nthreads;
+}
+
+typedef struct {
+  char *base;
+  size_t bytes;
+} TouchJob;
+
+static void first_touch_worker(int tid, int nthreads, void *arg) {
+  TouchJob *j = arg;
+  long lo, hi;
+  long page = sysconf(_SC_PAGESIZE);
+  thread_range(tid, nthreads, (long)j->bytes, &lo, &hi);
+  for(long off=lo - lo % page; off<hi; off+=page) {
+    if(off >= lo || tid == 0) j->base[off] = 0;
+  }
+}
+
+#define MPOL_INTERLEAVE_MODE 3
+
+/* Applies the placement policy to an untouched numa_alloc() region.
+ * PLACE_LOCAL first-touches slice t of the region from thread t, which
+ * matches the thread_range() split every parallel engine uses over node
+ * ids. PLACE_INTERLEAVE spreads pages round-robin over all sockets via
+ * mbind(2); without kernel support it falls back to default placement. */
+void numa_place(void *p, size_t bytes, placement_t placement, int nthreads) {
+  if(placement == PLACE_LOCAL) {
+    TouchJob j = { p, bytes };
+    run_parallel(nthreads, first_touch_worker, &j);
+  } else if(placement == PLACE_INTERLEAVE) {
+#ifdef SYS_mbind
+    detect_topology();
+    unsigned long mask = numa_nodes >= 64 ? ~0UL : (1UL << numa_nodes) - 1;
+    if(syscall(SYS_mbind, p, bytes, MPOL_INTERLEAVE_MODE, &mask,
+               sizeof(mask) * 8, 0) != 0) {
+      LOG_WARN("mbind interleave failed, using default placement\n");
+    }
+#else
+    LOG_WARN("mbind unavailable, using default placement\n");
+#endif
+  }
+}
+
+/* ----------------- Thread autotuning ------------------ */
+
+/* With --autotune (or --threads=auto) each parallel phase picks its own
+ * thread count. The first call for a phase in a given size and density
+ * class times the phase at 1, 2, 4 ... up to num_threads threads, best
+ * of AUTOTUNE_REPS each, and keeps the fastest; later calls in that
+ * class reuse the decision. Tuning re-runs the phase, so its worker must
+ * give the same result each time once prepare() has reset the shared
+ * state. Without autotuning the caller's default stands. */
+#define AUTOTUNE_REPS 3
+#define TUNE_SIZE_CLASSES 32
+#define TUNE_DENSITY_CLASSES 8
+
+typedef enum {
+  TUNE_ROUTING_LOAD = 0,
+  TUNE_LEAF_CANDIDATES,
+  TUNE_ENERGY_HEAPS,
+  TUNE_PARTITION,
+  TUNE_PHASES
+} tune_phase_t;
+
+static const char *tune_phase_names[] = {
+  "routing load", "leaf candidates", "energy heaps", "partition round"
+};
+static const char *tune_phase_keys[] = {
+  "routing-load", "leaf-candidates", "energy-heaps", "partition-round"
+};
+
+typedef struct {
+  int threads;             /* 0 until calibrated */
+  long work;               /* size and density it was calibrated at */
+  double density;
+  double seq_ms;
+  double best_ms;
+  int calls;
+  int cached;              /* decision came from the profile cache */
+} TuneEntry;
+
+static int autotune = 0;
+static TuneEntry tune_table[TUNE_PHASES][TUNE_SIZE_CLASSES][TUNE_DENSITY_CLASSES];
+
+/* floor(log2(work)) */
+static int tune_size_class(long work) {
+  int c = 0;
+  while(work > 1 && c < TUNE_SIZE_CLASSES - 1) {
+    work >>= 1;
+    c++;
+  }
+  return c;
+}
+
+/* Links per item: < 1, < 2, < 4 ... >= 64 */
+static int tune_density_class(double density) {
+  int c = 0;
+  while(density >= 1.0 && c < TUNE_DENSITY_CLASSES - 1) {
+    density /= 2;
+    c++;
+  }
+  return c;
+}
+
+static double tune_time(int nthreads, worker_fn fn, void *arg, prepare_fn prepare, int *team) {
+  double best = -1.0;
+  for(int r=0; r<AUTOTUNE_REPS; r++) {
+    double start = get_time_ms();
+    *team = run_parallel_team(nthreads, fn, arg, prepare);
+    double ms = get_time_ms() - start;
+    if(best < 0 || ms < best) best = ms;
+  }
+  return best;
+}
+
+/* Runs fn over work items of the given density and returns the thread
+ * count used. prepare may be NULL when the worker needs no reset. */
+int autotune_run(tune_phase_t phase, long work, double density, int default_threads,
+                 worker_fn fn, void *arg, prepare_fn prepare) {
+  if(!autotune) return run_parallel_team(default_threads, fn, arg, prepare);
+
+  TuneEntry *e = &tune_table[phase][tune_size_class(work)][tune_density_class(density)];
+  e->calls++;
+  if(e->threads > 0) return run_parallel_team(e->threads, fn, arg, prepare);
+
+  /* Calibration. Callers read per-thread results laid out by the team
+   * size they are given back, so unless the last trial ran at the
+   * chosen count, the phase runs once more at that count. */
+  e->work = work;
+  e->density = density;
+  e->threads = 1;
+  int team;
+  e->seq_ms = e->best_ms = tune_time(1, fn, arg, prepare, &team);
+  for(int t=2; t<2*num_threads; t*=2) {
+    if(t > num_threads) t = num_threads;
+    double ms = tune_time(t, fn, arg, prepare, &team);
+    if(ms < e->best_ms) {
+      e->best_ms = ms;
+      e->threads = t;
+    }
+  }
+  if(team != e->threads) team = run_parallel_team(e->threads, fn, arg, prepare);
+  return team;
+}
+
+/* Decisions so far, one line per phase and class */
+void print_autotune_report(void) {
+  if(!autotune) return;
+  printf("Thread autotuning (up to %d threads):\n", num_threads);
+  printf("  %-16s %10s %8s %8s %10s %10s %6s %s\n",
+         "phase", "work", "density", "threads", "1T ms", "best ms", "calls", "from");
+  for(int p=0; p<TUNE_PHASES; p++) {
+    for(int sc=0; sc<TUNE_SIZE_CLASSES; sc++) {
+      for(int dc=0; dc<TUNE_DENSITY_CLASSES; dc++) {
+        const TuneEntry *e = &tune_table[p][sc][dc];
+        if(e->calls == 0) continue;
+        printf("  %-16s %10ld %8.1f %8d %10.3f %10.3f %6d %s\n", tune_phase_names[p],
+               e->work, e->density, e->threads, e->seq_ms, e->best_ms, e->calls,
+               e->cached ? "cache" : "run");
+      }
+    }
+  }
+  printf("\n");
+}
+
+/* ----------------- Parallel connectivity engine ------------------ */
+
+/* Lock-free union-find: roots are linked larger-id under smaller-id with
+ * compare-and-swap, so concurrent unions never lose a link. */
+static int uf_find(int *parent, int x) {
+  for(;;) {
+    int p = __atomic_load_n(&parent[x], __ATOMIC_RELAXED);
+    if(p == x) return x;
+    int gp = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+    if(gp != p) __atomic_compare_exchange_n(&parent[x], &p, gp, 0,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    x = gp;
+  }
+}
+
+static void uf_union(int *parent, int a, int b) {
+  for(;;) {
+    a = uf_find(parent, a);
+    b = uf_find(parent, b);
+    if(a == b) return;
+    if(a < b) { int t = a; a = b; b = t; }
+    int expect = a;
+    if(__atomic_compare_exchange_n(&parent[a], &expect, b, 0,
+                                   __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return;
+  }
+}
+
+typedef struct {
+  const CsrGraph *g;
+  int *comp;
+  const int *members;      /* partition-scheduled unions, else NULL */
+  const int *member_start;
+  int nparts;
+  int next_part;
+} ConnJob;
+
+static void conn_init_worker(int tid, int nthreads, void *arg) {
+  ConnJob *j = arg;
+  long lo, hi;
+  thread_range(tid, nthreads, j->g->n, &lo, &hi);
+  for(long u=lo; u<hi; u++) j->comp[u] = (int)u;
+}
+
+static void conn_union_worker(int tid, int nthreads, void *arg) {
+  ConnJob *j = arg;
+  long lo, hi;
+  thread_range(tid, nthreads, j->g->n, &lo, &hi);
+  for(long u=lo; u<hi; u++) {
+    for(int i=j->g->offsets[u]; i<j->g->offsets[u + 1]; i++) {
+      int v = j->g->targets[i];
+      if(v < u) uf_union(j->comp, (int)u, v);
+    }
+  }
+}
+
+/* Unions a whole partition at a time, so a thread's compare-and-swaps
+ * mostly hit roots in its own partition rather than its neighbours' */
+static void conn_union_parts_worker(int tid, int nthreads, void *arg) {
+  ConnJob *j = arg;
+  (void)tid;
+  (void)nthreads;
+  for(;;) {
+    int p = __atomic_fetch_add(&j->next_part, 1, __ATOMIC_RELAXED);
+    if(p >= j->nparts) return;
+    for(int k=j->member_start[p]; k<j->member_start[p + 1]; k++) {
+      int u = j->members[k];
+      for(int i=j->g->offsets[u]; i<j->g->offsets[u + 1]; i++) {
+        int v = j->g->targets[i];
+        if(v < u) uf_union(j->comp, u, v);
+      }
+    }
+  }
+}
+
+static void conn_compress_worker(int tid, int nthreads, void *arg) {
+  ConnJob *j = arg;
+  long lo, hi;
+  thread_range(tid, nthreads, j->g->n, &lo, &hi);
+  for(long u=lo; u<hi; u++) j->comp[u] = uf_find(j->comp, (int)u);
+}
+
+/* Connected components of g into comp[] (label = smallest node id of the
+ * component). comp must already be placed; returns component count. */
+int parallel_components(const CsrGraph *g, int *comp, int nthreads) {
+  ConnJob j = { g, comp, NULL, NULL, 0, 0 };
+  run_parallel(nthreads, conn_init_worker, &j);
+  run_parallel(nthreads, conn_union_worker, &j);
+  run_parallel(nthreads, conn_compress_worker, &j);
+
+  int count = 0;
+  for(int u=0; u<g->n; u++) if(comp[u] == u) count++;
+  return count;
+}
+
+/* parallel_components() with the unions scheduled by partition:
+ * members[member_start[p] .. member_start[p+1]) are the nodes of part
+ * p. Same labels. */
+int partitioned_components(const CsrGraph *g, const int *members, const int *member_start,
+                           int nparts, int *comp, int nthreads) {
+  ConnJob j = { g, comp, members, member_start, nparts, 0 };
+  run_parallel(nthreads, conn_init_worker, &j);
+  run_parallel(nthreads, conn_union_parts_worker, &j);
+  run_parallel(nthreads, conn_compress_worker, &j);
+
+  int count = 0;
+  for(int u=0; u<g->n; u++) if(comp[u] == u) count++;
+  return count;
+}
+
+/* ----------------- Graph partitioning ------------------ */
+
+/* Balanced partitions for the parallel stages: part[v] in [0, nparts).
+ * Label propagation starts from ranges of a breadth-first order, which
+ * keeps each part a few BFS layers thick whatever the id numbering, and
+ * then moves a node to the label most of its neighbours carry. Each
+ * round is synchronous: proposals are made against the labels of the
+ * previous round, by all threads over id ranges, and admitted in id
+ * order while the target stays below capacity. Only half the nodes may
+ * move per round, chosen by hash, so neighbours do not swap labels back
+ * and forth. The result depends only on the graph, not on the thread
+ * count. Users: hierarchical analysis, partition-scheduled connectivity,
+ * the "parts" layout of the verification pass and --export-csr with
+ * --parts=K. */
+#define PART_IMBALANCE 0.03
+#define PART_MAX_ROUNDS 20
+
+typedef enum { PARTITION_RANGE = 0, PARTITION_LABEL_PROP } partitioner_t;
+static const char *partitioner_names[] = { "range", "lp" };
+
+typedef struct {
+  long edge_cut;           /* links between partitions */
+  double cut_fraction;
+  int max_size;
+  double imbalance;        /* largest part over the mean */
+  int rounds;
+  long moves;
+  double ms;
+} PartStats;
+
+typedef struct {
+  const CsrGraph *g;
+  const int *part;         /* labels of the previous round */
+  int nparts;
+  int *tally;              /* nparts zeroed counters per thread */
+  int round;
+  int *proposal;           /* node ids, thread t from lo(t) onwards */
+  int *target;
+  int count[MAX_CPUS];
+} PartJob;
+
+/* Contiguous id ranges, for graphs numbered by site */
+void partition_by_range(int n, int nparts, int *part) {
+  for(int v=0; v<n; v++) part[v] = (int)((long)v * nparts / n);
+}
+
+/* Breadth-first order of all components, each from its lowest id */
+static void bfs_order(const CsrGraph *g, int *order, char *seen) {
+  int head = 0, tail = 0;
+  for(int r=0; r<g->n; r++) {
+    if(seen[r]) continue;
+    seen[r] = 1;
+    order[tail++] = r;
+    while(head < tail) {
+      int u = order[head++];
+      for(int c=g->offsets[u]; c<g->offsets[u + 1]; c++) {
+        int v = g->targets[c];
+        if(!seen[v]) {
+          seen[v] = 1;
+          order[tail++] = v;
+        }
+      }
+    }
+  }
+}
+
+/* Nodes grouped by partition: members[start[p] .. start[p+1]). start
+ * must be zeroed; cursor is nparts ints of scratch. */
+void partition_members(int n, const int *part, int nparts, int *members, int *start,
+                       int *cursor) {
+  for(int v=0; v<n; v++) start[part[v] + 1]++;
+  for(int p=0; p<nparts; p++) start[p + 1] += start[p];
+  memcpy(cursor, start, sizeof(int) * (size_t)nparts);
+  for(int v=0; v<n; v++) members[cursor[part[v]]++] = v;
+}
+
+/* Edge cut and balance of part[] into st */
+void partition_quality(const CsrGraph *g, const int *part, int nparts, PartStats *st) {
+  int *size = calloc(nparts, sizeof(int));
+  long cut = 0;
+  for(int v=0; v<g->n; v++) {
+    for(int c=g->offsets[v]; c<g->offsets[v + 1]; c++) {
+      if(part[g->targets[c]] != part[v]) cut++;
+    }
+  }
+  st->edge_cut = cut / 2;
+  st->cut_fraction = g->m > 0 ? (double)cut / g->m : 0.0;
+
+  st->max_size = 0;
+  if(size) {
+    for(int v=0; v<g->n; v++) size[part[v]]++;
+    for(int p=0; p<nparts; p++) if(size[p] > st->max_size) st->max_size = size[p];
+    free(size);
+  }
+  st->imbalance = g->n > 0 ? (double)st->max_size * nparts / g->n : 0.0;
+}
+
+/* Proposes for each node of this round's half the neighbour label with
+ * the most links, ties to the lowest label. Labels are counted in the
+ * thread's tally, two passes over the adjacency; the second pass reads
+ * each label's count once and clears it, leaving the tally zeroed. */
+static void lp_propose_worker(int tid, int nthreads, void *arg) {
+  PartJob *j = arg;
+  const CsrGraph *g = j->g;
+  int *tally = j->tally + (size_t)tid * j->nparts;
+  long lo, hi;
+  thread_range(tid, nthreads, g->n, &lo, &hi);
+  int count = 0;
+
+  for(long v=lo; v<hi; v++) {
+    if(((hash_u32((unsigned int)v) ^ (unsigned int)j->round) & 1) != 0) continue;
+
+    int own = j->part[v], best = own, best_links = 0;
+    int first = g->offsets[v], end = g->offsets[v + 1];
+    for(int c=first; c<end; c++) tally[j->part[g->targets[c]]]++;
+    int own_links = tally[own];
+    for(int c=first; c<end; c++) {
+      int label = j->part[g->targets[c]], links = tally[label];
+      if(label == own || links == 0) continue;
+      tally[label] = 0;
+      if(links > best_links || (links == best_links && label < best)) {
+        best = label;
+        best_links = links;
+      }
+    }
+    tally[own] = 0;
+    if(best != own && best_links > own_links) {
+      j->proposal[lo + count] = (int)v;
+      j->target[lo + count] = best;
+      count++;
+    }
+  }
+  j->count[tid] = count;
+}
+
+/* Fills part[] and returns 0, or -1 when out of memory */
+int label_propagation_partition(const CsrGraph *g, int nparts, int *part, int nthreads,
+                                PartStats *st) {
+  int n = g->n;
+  size_t bytes = sizeof(int) * (size_t)n;
+  size_t size_bytes = sizeof(int) * (size_t)nparts;
+  size_t tally_bytes = size_bytes * (size_t)(nthreads > 0 ? nthreads : 1);
+  PartJob j;
+  memset(&j, 0, sizeof(j));
+  j.g = g;
+  j.part = part;
+  j.nparts = nparts;
+  j.proposal = numa_alloc(bytes);
+  j.target = numa_alloc(bytes);
+  j.tally = numa_alloc(tally_bytes);
+  int *size = numa_alloc(size_bytes);
+  int result = -1;
+  memset(st, 0, sizeof(*st));
+
+  if(!j.proposal || !j.target || !j.tally || !size) {
+    LOG_ERR("Out of memory for %d-node partitioning\n", n);
+    goto out;
+  }
+
+  double start = get_time_ms();
+  int capacity = (int)((double)n / nparts * (1.0 + PART_IMBALANCE)) + 1;
+  char *seen = (char *)j.target;   /* free until the first round */
+  memset(seen, 0, n);
+  bfs_order(g, j.proposal, seen);
+  for(int i=0; i<n; i++) part[j.proposal[i]] = (int)((long)i * nparts / n);
+  for(int v=0; v<n; v++) size[part[v]]++;
+
+  for(int round=0; round<PART_MAX_ROUNDS; round++) {
+    j.round = round;
+    int used = autotune_run(TUNE_PARTITION, n, (double)g->m / n, nthreads,
+                            lp_propose_worker, &j, NULL);
+
+    long moved = 0;
+    for(int t=0; t<used; t++) {
+      long lo, hi;
+      thread_range(t, used, n, &lo, &hi);
+      for(int i=0; i<j.count[t]; i++) {
+        int v = j.proposal[lo + i], b = j.target[lo + i];
+        if(size[b] >= capacity) continue;
+        size[part[v]]--;
+        size[b]++;
+        part[v] = b;
+        moved++;
+      }
+    }
+    st->rounds = round + 1;
+    st->moves += moved;
+    /* Odd and even halves both settled */
+    if(moved <= n / 1000 && round > 0) break;
+  }
+  st->ms = get_time_ms() - start;
+
+  partition_quality(g, part, nparts, st);
+  result = 0;
+
+out:
+  numa_free(j.proposal, bytes);
+  numa_free(j.target, bytes);
+  numa_free(j.tally, tally_bytes);
+  numa_free(size, size_bytes);
+  return result;
+}
+
+/* Partitions g with the chosen method, filling st */
+int partition_graph(const CsrGraph *g, partitioner_t method, int nparts, int *part,
+                    PartStats *st) {
+  if(method == PARTITION_LABEL_PROP) {
+    return label_propagation_partition(g, nparts, part, num_threads, st);
+  }
+  memset(st, 0, sizeof(*st));
+  double start = get_time_ms();
+  partition_by_range(g->n, nparts, part);
+  st->ms = get_time_ms() - start;
+  partition_quality(g, part, nparts, st);
+  return 0;
+}
+
+/* Renumbering of a graph of at most MAX_NODES nodes into h, node
+ * order[i] becoming i. h uses static storage shared by the layouts
+ * below, so it lasts until the next renumbering. */
+static void csr_renumber(const CsrGraph *g, const int *order, CsrGraph *h, int *newid) {
+  static int offs[MAX_NODES + 1], tgts[MAX_NODES * MAX_NEIGHBORS];
+
+  for(int i=0; i<g->n; i++) newid[order[i]] = i;
+  offs[0] = 0;
+  for(int i=0; i<g->n; i++) {
+    int u = order[i], k = offs[i];
+    for(int c=g->offsets[u]; c<g->offsets[u + 1]; c++) tgts[k++] = newid[g->targets[c]];
+    offs[i + 1] = k;
+  }
+  h->n = g->n;
+  h->m = g->m;
+  h->offsets = offs;
+  h->targets = tgts;
+}
+
+/* Breadth-first renumbering of g into h */
+static void csr_bfs_layout(const CsrGraph *g, CsrGraph *h, int *newid) {
+  static int order[MAX_NODES];
+  static char seen[MAX_NODES];
+
+  memset(seen, 0, g->n);
+  bfs_order(g, order, seen);
+  csr_renumber(g, order, h, newid);
+}
+
+/* Renumbering of g into h partition by partition, each partition in
+ * breadth-first order, so every label-propagation part occupies one id
+ * range. Falls back to the breadth-first layout if partitioning fails. */
+static void csr_partition_layout(const CsrGraph *g, int nparts, CsrGraph *h, int *newid) {
+  static int order[MAX_NODES], bfs[MAX_NODES], part[MAX_NODES];
+  static char seen[MAX_NODES];
+  PartStats st;
+
+  memset(seen, 0, g->n);
+  bfs_order(g, bfs, seen);
+  if(nparts < 2 || g->n < nparts ||
+     partition_graph(g, PARTITION_LABEL_PROP, nparts, part, &st) < 0) {
+    csr_renumber(g, bfs, h, newid);
+    return;
+  }
+
+  /* Stable bucket sort of the BFS order by part */
+  int *start = calloc((size_t)nparts + 1, sizeof(int));
+  if(!start) {
+    csr_renumber(g, bfs, h, newid);
+    return;
+  }
+  for(int v=0; v<g->n; v++) start[part[v] + 1]++;
+  for(int p=0; p<nparts; p++) start[p + 1] += start[p];
+  for(int i=0; i<g->n; i++) order[start[part[bfs[i]]]++] = bfs[i];
+  free(start);
+  csr_renumber(g, order, h, newid);
+}
+
+/* Writes the in-memory graph for --external. With --parts=K it is
+ * renumbered by partitions first, so the external pass walks one
+ * partition's id range at a time and its residency window stays
+ * local. */
+void export_csr_graph(const char *fname) {
+  static int newid[MAX_NODES];
+  CsrGraph g;
+  csr_from_graph(&g);
+  if(hier_parts > 1) {
+    CsrGraph h;
+    csr_partition_layout(&g, hier_parts, &h, newid);
+    LOG_INFO("Renumbered %d nodes by %d partitions for export\n", g.n, hier_parts);
+    csr_write_file(fname, &h);
+  } else {
+    csr_write_file(fname, &g);
+  }
+}
+
+/* ----------------- Hierarchical analysis ------------------ */
+
+/* Exact cut vertices of a large graph from per-partition work. Every
+ * partition finds the blocks of its induced subgraph and replaces each
+ * block by a star whose hub joins the block's kept nodes: those on the
+ * partition boundary or heading a local block. A node in one local
+ * block with no outside link is never a cut vertex of the whole graph,
+ * since the rest of its block stays connected, so it is dropped. The
+ * partitions run in parallel; one Tarjan pass over the reduced graph of
+ * kept nodes, hubs and cross-partition links then marks exactly the cut
+ * vertices of the original. */
+#define HIER_PART_NODES 65536
+
+typedef struct {
+  Edge *edges;             /* reduced links; hub h is -(h + 1) */
+  int nedges, cap;
+  int hubs;
+  int failed;
+} HierPart;
+
+typedef struct {
+  const CsrGraph *g;
+  const int *part;
+  int nparts;
+  int *members;            /* nodes grouped by partition */
+  int *member_start;       /* nparts + 1 entries */
+  HierPart *parts;
+  int *disc, *low, *parent, *cursor, *stack, *vstack;
+  char *kept, *boundary, *is_head;
+  int next_part;           /* shared work counter */
+} HierJob;
+
+typedef struct {
+  int nparts;
+  int boundary;            /* nodes with a link to another partition */
+  int kept;
+  int hubs;
+  int reduced_m;           /* adjacency entries of the reduced graph */
+  double local_ms, reduce_ms, global_ms;
+} HierStats;
+
+static void hier_link(HierPart *hp, int a, int b) {
+  if(hp->nedges == hp->cap) {
+    int cap = hp->cap ? 2 * hp->cap : 1024;
+    Edge *e = realloc(hp->edges, sizeof(Edge) * (size_t)cap);
+    if(!e) {
+      hp->failed = 1;
+      return;
+    }
+    hp->edges = e;
+    hp->cap = cap;
+  }
+  hp->edges[hp->nedges++] = (Edge){ a, b };
+}
+
+/* Closes the local block headed by h: u and everything above it on the
+ * vertex stack. Two kept nodes are linked directly, otherwise through a
+ * hub; a lone kept head still gets a hub, which keeps it a cut vertex
+ * of the reduced graph. */
+static void hier_block(HierJob *j, HierPart *hp, int h, int u, int *vstack, int *vsp) {
+  int lo = *vsp - 1;
+  while(vstack[lo] != u) lo--;
+
+  int k = 1, other = -1;
+  for(int i=lo; i<*vsp; i++) {
+    int w = vstack[i];
+    if(j->boundary[w] || j->is_head[w]) {
+      j->kept[w] = 1;
+      other = w;
+      k++;
+    }
+  }
+  j->kept[h] = j->is_head[h] = 1;
+
+  if(k == 2) {
+    hier_link(hp, h, other);
+  } else {
+    int hub = -(++hp->hubs);
+    hier_link(hp, hub, h);
+    for(int i=lo; i<*vsp; i++) {
+      if(j->kept[vstack[i]]) hier_link(hp, hub, vstack[i]);
+    }
+  }
+  *vsp = lo;
+}
+
+/* Iterative vertex-stack Tarjan over each partition's induced subgraph.
+ * Partitions are taken from a shared counter; a partition's stacks live
+ * in its slice of the member range, so no two threads share a word. */
+static void hier_local_worker(int tid, int nthreads, void *arg) {
+  HierJob *j = arg;
+  const CsrGraph *g = j->g;
+  (void)tid; (void)nthreads;
+
+  for(;;) {
+    int p = __atomic_fetch_add(&j->next_part, 1, __ATOMIC_RELAXED);
+    if(p >= j->nparts) break;
+
+    HierPart *hp = &j->parts[p];
+    int base = j->member_start[p];
+    int *stack = j->stack + base, *vstack = j->vstack + base;
+    int t = 0;
+
+    for(int i=base; i<j->member_start[p + 1]; i++) {
+      int r = j->members[i];
+      if(j->disc[r] != EXT_UNVISITED) continue;
+
+      int sp = 0, vsp = 0;
+      j->disc[r] = j->low[r] = ++t;
+      j->parent[r] = -1;
+      j->cursor[r] = g->offsets[r];
+      stack[sp++] = r;
+      vstack[vsp++] = r;
+
+      while(sp > 0) {
+        int u = stack[sp - 1];
+        if(j->cursor[u] < g->offsets[u + 1]) {
+          int v = g->targets[j->cursor[u]++];
+          if(j->part[v] != p) {
+            j->boundary[u] = 1;
+            if(u < v) hier_link(hp, u, v);
+          } else if(j->disc[v] == EXT_UNVISITED) {
+            j->parent[v] = u;
+            j->disc[v] = j->low[v] = ++t;
+            j->cursor[v] = g->offsets[v];
+            stack[sp++] = v;
+            vstack[vsp++] = v;
+          } else if(v != j->parent[u] && j->disc[v] < j->low[u]) {
+            j->low[u] = j->disc[v];
+          }
+        } else {
+          sp--;
+          int pu = j->parent[u];
+          if(pu >= 0) {
+            if(j->low[u] < j->low[pu]) j->low[pu] = j->low[u];
+            if(j->low[u] >= j->disc[pu]) hier_block(j, hp, pu, u, vstack, &vsp);
+          }
+        }
+      }
+
+      /* Without local links r only matters through its outside ones */
+      if(j->boundary[r]) j->kept[r] = 1;
+    }
+  }
+}
+
+/* Cut vertices of g into cut[] given part[v] in [0, nparts). Returns
+ * the count, or -1 when out of memory. */
+int hier_cut_vertices(const CsrGraph *g, const int *part, int nparts, char *cut,
+                      HierStats *st) {
+  int n = g->n, count = -1;
+  size_t bytes = sizeof(int) * (size_t)n;
+  size_t start_bytes = sizeof(int) * ((size_t)nparts + 1);
+  HierJob j;
+  memset(&j, 0, sizeof(j));
+  memset(st, 0, sizeof(*st));
+  st->nparts = nparts;
+
+  j.g = g;
+  j.part = part;
+  j.nparts = nparts;
+  /* numa_alloc() memory reads as zeroes: disc[] starts EXT_UNVISITED,
+   * member_start[] as the zeroed counts partition_members() expects,
+   * and kept[], boundary[] and is_head[] all clear */
+  j.members = numa_alloc(bytes);
+  j.member_start = numa_alloc(start_bytes);
+  j.parts = calloc(nparts, sizeof(HierPart));
+  j.disc = numa_alloc(bytes);
+  j.low = numa_alloc(bytes);
+  j.parent = numa_alloc(bytes);
+  j.cursor = numa_alloc(bytes);
+  j.stack = numa_alloc(bytes);
+  j.vstack = numa_alloc(bytes);
+  j.kept = numa_alloc(n);
+  j.boundary = numa_alloc(n);
+  j.is_head = numa_alloc(n);
+  int *hub_base = malloc(sizeof(int) * (size_t)nparts);
+  int *roffs = NULL, *rtgts = NULL, *rcursor = NULL;
+  char *rcut = NULL;
+  size_t roffs_bytes = 0, rtgts_bytes = 0;
+  int rn = 0;
+
+  if(!j.members || !j.member_start || !j.parts || !j.disc || !j.low || !j.parent ||
+     !j.cursor || !j.stack || !j.vstack || !j.kept || !j.boundary || !j.is_head ||
+     !hub_base) {
+    LOG_ERR("Out of memory for %d-node hierarchical analysis\n", n);
+    goto out;
+  }
+
+  /* Local blocks, partition by partition */
+  double start = get_time_ms();
+  partition_members(n, part, nparts, j.members, j.member_start, j.cursor);
+  run_parallel(num_threads, hier_local_worker, &j);
+  st->local_ms = get_time_ms() - start;
+
+  for(int p=0; p<nparts; p++) {
+    if(j.parts[p].failed) {
+      LOG_ERR("Out of memory for partition %d links\n", p);
+      goto out;
+    }
+  }
+
+  /* Reduced graph: kept nodes first (the local low[] is free again and
+   * holds their new ids), then each partition's hubs */
+  start = get_time_ms();
+  int *newid = j.low;
+  for(int v=0; v<n; v++) {
+    if(j.boundary[v]) st->boundary++;
+    newid[v] = j.kept[v] ? rn++ : -1;
+  }
+  st->kept = rn;
+  long rm = 0;
+  for(int p=0; p<nparts; p++) {
+    hub_base[p] = rn;
+    rn += j.parts[p].hubs;
+    st->hubs += j.parts[p].hubs;
+    rm += 2L * j.parts[p].nedges;
+  }
+  if(rm > INT_MAX) {
+    LOG_ERR("Reduced graph too large (%ld adjacency entries)\n", rm);
+    goto out;
+  }
+  st->reduced_m = (int)rm;
+
+  roffs_bytes = sizeof(int) * ((size_t)rn + 1);
+  rtgts_bytes = sizeof(int) * (size_t)(rm > 0 ? rm : 1);
+  /* kept + hubs can exceed n, so the fill cursor gets its own array */
+  roffs = numa_alloc(roffs_bytes);
+  rtgts = numa_alloc(rtgts_bytes);
+  rcursor = numa_alloc(roffs_bytes);
+  rcut = malloc(rn > 0 ? rn : 1);
+  if(!roffs || !rtgts || !rcursor || !rcut) {
+    LOG_ERR("Out of memory for the reduced graph\n");
+    goto out;
+  }
+
+#define HIER_ID(x, p) ((x) >= 0 ? newid[x] : hub_base[p] - (x) - 1)
+  for(int p=0; p<nparts; p++) {
+    for(int e=0; e<j.parts[p].nedges; e++) {
+      roffs[HIER_ID(j.parts[p].edges[e].u, p) + 1]++;
+      roffs[HIER_ID(j.parts[p].edges[e].v, p) + 1]++;
+    }
+  }
+  for(int i=0; i<rn; i++) roffs[i + 1] += roffs[i];
+  memcpy(rcursor, roffs, sizeof(int) * (size_t)rn);
+  for(int p=0; p<nparts; p++) {
+    for(int e=0; e<j.parts[p].nedges; e++) {
+      int a = HIER_ID(j.parts[p].edges[e].u, p);
+      int b = HIER_ID(j.parts[p].edges[e].v, p);
+      rtgts[rcursor[a]++] = b;
+      rtgts[rcursor[b]++] = a;
+    }
+  }
+#undef HIER_ID
+  st->reduce_ms = get_time_ms() - start;
+
+  /* One global pass, mapped back to the original ids */
+  start = get_time_ms();
+  CsrGraph r = { rn, (int)rm, roffs, rtgts };
+  if(csr_cut_vertices(&r, rcut, NULL) < 0) goto out;
+  count = 0;
+  for(int v=0; v<n; v++) {
+    cut[v] = newid[v] >= 0 && rcut[newid[v]];
+    count += cut[v];
+  }
+  st->global_ms = get_time_ms() - start;
+
+out:
+  if(j.parts) {
+    for(int p=0; p<nparts; p++) free(j.parts[p].edges);
+  }
+  free(j.parts);
+  free(hub_base);
+  free(rcut);
+  numa_free(roffs, roffs_bytes);
+  numa_free(rtgts, rtgts_bytes);
+  numa_free(rcursor, roffs_bytes);
+  numa_free(j.members, bytes);
+  numa_free(j.member_start, start_bytes);
+  numa_free(j.disc, bytes);
+  numa_free(j.low, bytes);
+  numa_free(j.parent, bytes);
+  numa_free(j.cursor, bytes);
+  numa_free(j.stack, bytes);
+  numa_free(j.vstack, bytes);
+  numa_free(j.kept, n);
+  numa_free(j.boundary, n);
+  numa_free(j.is_head, n);
+  return count;
+}
+
+/* ----------------- Engine selection ------------------ */
+
+/* With --engine=auto the verification pass picks its engine and layout
+ * per graph class (the size and density classes of the autotuner). The
+ * first graph of a class times every candidate: the recursive DFS over
+ * the static adjacency, and the iterative lowpoint and chain engines
+ * over the CSR snapshot, in id order, renumbered breadth-first, or
+ * renumbered by label-propagation parts of LAYOUT_PART_NODES nodes.
+ * The fastest is kept for later graphs of that class, and the profile
+ * cache carries it across runs. */
+typedef enum { FINAL_RECURSIVE = 0, FINAL_ITERATIVE, FINAL_CHAIN, FINAL_ENGINES } final_engine_t;
+typedef enum { LAYOUT_IDS = 0, LAYOUT_BFS, LAYOUT_PARTS, LAYOUTS } layout_t;
+
+static const char *final_engine_names[] = { "recursive", "iterative", "chain" };
+static const char *layout_names[] = { "ids", "bfs", "parts" };
+
+/* Nodes per part of the "parts" layout: about what stays in L2 */
+#define LAYOUT_PART_NODES 256
+
+typedef struct {
+  int engine;
+  int layout;
+  double ms;
+  int n;
+  double density;
+  int calls;
+  int cached;
+} EngineChoice;
+
+static int engine_auto = 0;
+static EngineChoice engine_choice[TUNE_SIZE_CLASSES][TUNE_DENSITY_CLASSES];
+static EngineChoice *engine_last = NULL;
+
+/* One verification pass: fills is_cut and num_blocks */
+static void final_engine_run(const CsrGraph *g, int engine, int layout) {
+  static int newid[MAX_NODES];
+  static char cut[MAX_NODES];
+
+  if(engine == FINAL_RECURSIVE) {
+    find_cut_vertices();
+    return;
+  }
+
+  CsrGraph h = *g;
+  if(layout == LAYOUT_BFS) csr_bfs_layout(g, &h, newid);
+  if(layout == LAYOUT_PARTS) {
+    csr_partition_layout(g, (g->n + LAYOUT_PART_NODES - 1) / LAYOUT_PART_NODES, &h, newid);
+  }
+  char *out = layout != LAYOUT_IDS ? cut : is_cut;
+
+  if(engine == FINAL_CHAIN) {
+    ChainResult res;
+    chain_cut_vertices(&h, out, &res);
+    num_blocks = res.bridges + res.cycles;
+  } else {
+    csr_cut_blocks(&h, out, NULL, &num_blocks);
+  }
+  if(layout != LAYOUT_IDS) {
+    for(int v=0; v<g->n; v++) is_cut[v] = cut[newid[v]];
+  }
+  blocks_valid = 0;
+}
+
+/* Best-of-reps time of one candidate, repeated to cover about a
+ * million adjacency entries */
+static double final_engine_time(const CsrGraph *g, int engine, int layout) {
+  int reps = (int)(1000000L / (g->m + g->n + 1));
+  if(reps < 1) reps = 1;
+  if(reps > 200) reps = 200;
+
+  double best = -1.0;
+  for(int r=0; r<AUTOTUNE_REPS; r++) {
+    double start = get_time_ms();
+    for(int k=0; k<reps; k++) final_engine_run(g, engine, layout);
+    double ms = (get_time_ms() - start) / reps;
+    if(best < 0 || ms < best) best = ms;
+  }
+  return best;
+}
+
+void auto_final_analysis(void) {
+  CsrGraph g;
+  csr_from_graph(&g);
+  double density = g.n > 0 ? (double)g.m / g.n : 0.0;
+  EngineChoice *c = &engine_choice[tune_size_class(g.n)][tune_density_class(density)];
+
+  if(c->calls++ == 0 && !c->cached) {
+    /* The recursive pass runs first and is the reference; a candidate
+     * that marks other nodes or counts other blocks is never chosen */
+    static char reference[MAX_NODES];
+    int blocks = -1;
+    c->engine = -1;
+    for(int e=0; e<FINAL_ENGINES; e++) {
+      for(int l=0; l<(e == FINAL_RECURSIVE ? 1 : LAYOUTS); l++) {
+        double ms = final_engine_time(&g, e, l);
+        if(blocks < 0) {
+          memcpy(reference, is_cut, g.n);
+          blocks = num_blocks;
+        } else if(memcmp(reference, is_cut, g.n) != 0 || num_blocks != blocks) {
+          int count = 0;
+          for(int v=0; v<g.n; v++) count += is_cut[v];
+          LOG_WARN("%s/%s disagrees (%d cuts, %d blocks), not a candidate\n",
+                   final_engine_names[e], layout_names[l], count, num_blocks);
+          continue;
+        }
+        if(c->engine < 0 || ms < c->ms) {
+          c->engine = e;
+          c->layout = l;
+          c->ms = ms;
+        }
+      }
+    }
+    c->n = g.n;
+    c->density = density;
+  }
+  final_engine_run(&g, c->engine, c->layout);
+  engine_last = c;
+}
+
+/* The engine auto_final_analysis() would pick for the current graph
+ * without calibrating: the cached or earlier decision for its class, or
+ * -1 if there is none yet. A decision returned counts as used. */
+int auto_final_engine_recorded(void) {
+  long m = 0;
+  for(int u=0; u<n_nodes; u++) m += degree[u];
+  double density = n_nodes > 0 ? (double)m / n_nodes : 0.0;
+  EngineChoice *c = &engine_choice[tune_size_class(n_nodes)][tune_density_class(density)];
+
+  if(c->calls == 0 && !c->cached) return -1;
+  c->calls++;
+  engine_last = c;
+  return c->engine;
+}
+
+void print_engine_report(void) {
+  if(!engine_last) return;
+  printf("Verification engine: %s on %s layout, %.3f ms at %d nodes, density %.1f (%s)\n\n",
+         final_engine_names[engine_last->engine], layout_names[engine_last->layout],
+         engine_last->ms, engine_last->n, engine_last->density,
+         engine_last->cached ? "profile cache" : "calibrated this run");
+}
+
+/* ----------------- Profile cache ------------------ */
+
+/* Engine and thread-count decisions persist in a small text file, one
+ * line per decision, keyed by host name, online CPU count and graph
+ * class, so a later run on the same machine starts on the fastest path
+ * without calibrating. Thread counts are also keyed by the --threads
+ * ceiling they were calibrated under; entries for other ceilings are
+ * kept but not used. Lines for other machines are kept as they are.
+ * The file is rewritten (through a rename) only when this run
+ * calibrated something new. */
+#define PROFILE_MAX_LINES 512
+#define PROFILE_LINE 256
+
+static const char *profile_path = "cut-mesh.profile";
+static char *profile_foreign[PROFILE_MAX_LINES];
+static int profile_nforeign = 0;
+
+static void profile_identity(char *host, size_t len, long *ncpus) {
+  if(gethostname(host, len) != 0) snprintf(host, len, "unknown");
+  host[len - 1] = '\0';
+  for(char *p=host; *p; p++) if(*p == ' ') *p = '_';
+  *ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static int name_index(const char *name, const char **names, int count) {
+  for(int k=0; k<count; k++) if(strcmp(name, names[k]) == 0) return k;
+  return -1;
+}
+
+void profile_load(void) {
+  char host[64], line[PROFILE_LINE];
+  long ncpus;
+  int loaded = 0;
+
+  if(!engine_auto && !autotune) return;
+  FILE *f = fopen(profile_path, "r");
+  if(!f) return;
+  profile_identity(host, sizeof(host), &ncpus);
+
+  while(fgets(line, sizeof(line), f)) {
+    char kind[16], lhost[64], a[32], b[32];
+    long lcpus;
+    int sc, dc, threads, n;
+    double x, y, z;
+    long work;
+
+    if(line[0] == '#' || sscanf(line, "%15s %63s %ld", kind, lhost, &lcpus) != 3) continue;
+    if(strcmp(lhost, host) != 0 || lcpus != ncpus) {
+      if(profile_nforeign < PROFILE_MAX_LINES) profile_foreign[profile_nforeign++] = strdup(line);
+      continue;
+    }
+
+    if(strcmp(kind, "engine") == 0 &&
+       sscanf(line, "%*s %*s %*d %d %d %31s %31s %lf %d %lf", &sc, &dc, a, b, &x, &n, &y) == 7) {
+      int e = name_index(a, final_engine_names, FINAL_ENGINES);
+      int l = name_index(b, layout_names, LAYOUTS);
+      if(e < 0 || l < 0 || sc < 0 || sc >= TUNE_SIZE_CLASSES || dc < 0 ||
+         dc >= TUNE_DENSITY_CLASSES) continue;
+      engine_choice[sc][dc] = (EngineChoice){ e, l, x, n, y, 0, 1 };
+      loaded++;
+    } else if(strcmp(kind, "threads") == 0 &&
+              sscanf(line, "%*s %*s %*d %d %31s %d %d %d %ld %lf %lf %lf",
+                     &n, a, &sc, &dc, &threads, &work, &x, &y, &z) == 9) {
+      if(n != num_threads) {
+        if(profile_nforeign < PROFILE_MAX_LINES) profile_foreign[profile_nforeign++] = strdup(line);
+        continue;
+      }
+      int p = name_index(a, tune_phase_keys, TUNE_PHASES);
+      if(p < 0 || sc < 0 || sc >= TUNE_SIZE_CLASSES || dc < 0 ||
+         dc >= TUNE_DENSITY_CLASSES || threads < 1) continue;
+      TuneEntry *e = &tune_table[p][sc][dc];
+      e->threads = threads < num_threads ? threads : num_threads;
+      e->work = work;
+      e->density = x;
+      e->seq_ms = y;
+      e->best_ms = z;
+      e->cached = 1;
+      loaded++;
+    }
+  }
+  fclose(f);
+  LOG_INFO("Loaded %d profile entries for %s (%ld CPUs) from %s\n",
+           loaded, host, ncpus, profile_path);
+}
+
+void profile_save(void) {
+  char host[64], tmp[PROFILE_LINE];
+  long ncpus;
+  int fresh = 0;
+
+  for(int sc=0; sc<TUNE_SIZE_CLASSES; sc++) {
+    for(int dc=0; dc<TUNE_DENSITY_CLASSES; dc++) {
+      if(engine_choice[sc][dc].calls > 0 && !engine_choice[sc][dc].cached) fresh++;
+      for(int p=0; p<TUNE_PHASES; p++) {
+        if(tune_table[p][sc][dc].threads > 0 && !tune_table[p][sc][dc].cached) fresh++;
+      }
+    }
+  }
+  if(fresh == 0) return;
+
+  profile_identity(host, sizeof(host), &ncpus);
+  snprintf(tmp, sizeof(tmp), "%s.tmp", profile_path);
+  FILE *f = fopen(tmp, "w");
+  if(!f) {
+    LOG_ERR("Failed to open %s\n", tmp);
+    return;
+  }
+
+  fprintf(f, "# cut-mesh profile: engine host cpus size density engine layout ms nodes density\n");
+  fprintf(f, "#   threads host cpus max-threads phase size density threads work density 1T-ms best-ms\n");
+  for(int i=0; i<profile_nforeign; i++) fputs(profile_foreign[i], f);
+  for(int sc=0; sc<TUNE_SIZE_CLASSES; sc++) {
+    for(int dc=0; dc<TUNE_DENSITY_CLASSES; dc++) {
+      const EngineChoice *c = &engine_choice[sc][dc];
+      if(c->calls > 0 || c->cached) {
+        fprintf(f, "engine %s %ld %d %d %s %s %.6f %d %.3f\n", host, ncpus, sc, dc,
+                final_engine_names[c->engine], layout_names[c->layout], c->ms, c->n,
+                c->density);
+      }
+      for(int p=0; p<TUNE_PHASES; p++) {
+        const TuneEntry *e = &tune_table[p][sc][dc];
+        if(e->threads == 0) continue;
+        fprintf(f, "threads %s %ld %d %s %d %d %d %ld %.3f %.6f %.6f\n", host, ncpus,
+                num_threads, tune_phase_keys[p], sc, dc, e->threads, e->work, e->density,
+                e->seq_ms, e->best_ms);
+      }
+    }
+  }
+
+  if(fclose(f) != 0 || rename(tmp, profile_path) != 0) {
+    LOG_ERR("Failed to write %s\n", profile_path);
+    return;
+  }
+  LOG_INFO("Saved %d new profile entries to %s\n", fresh, profile_path);
+}
+
+/* ----------------- ETX shortest paths ------------------ */
+
+/* Link ETX in RPL fixed point (ETX_SCALE per transmission), capped at
+ * ten transmissions. A node's rank is RPL_ROOT_RANK plus the ETX sum of
+ * its path in the shortest-path tree from root 0. */
+#define ETX_SCALE 128
+#define ETX_MAX (10 * ETX_SCALE)
+#define RPL_ROOT_RANK 256
+#define SSSP_UNREACHED INT_MAX
+
+/* ETX from distance: delivery ratio falls from 1 next to a mote to 0.1
+ * at full radio range */
+static inline unsigned short etx_from_distance(double d) {
+  double ratio = d / RADIO_RANGE;
+  double prr = 1.0 - 0.9 * ratio * ratio;
+  if(prr <= 1.0 / 10) return ETX_MAX;
+  return (unsigned short)(ETX_SCALE / prr + 0.5);
+}
+
+/* ETX of the adjacency entries of nodes lo .. hi-1, from positions */
+static void etx_weight_rows(const CsrGraph *g, unsigned short *w, int lo, int hi) {
+  for(int u=lo; u<hi; u++) {
+    for(int c=g->offsets[u]; c<g->offsets[u + 1]; c++) {
+      w[c] = etx_from_distance(node_distance(u, g->targets[c]));
+    }
+  }
+}
+
+/* ETX of every adjacency entry of the static graph, from positions */
+void etx_weights_from_positions(const CsrGraph *g, unsigned short *w) {
+  etx_weight_rows(g, w, 0, g->n);
+}
+
+/* Symmetric hashed ETX for graphs without positions */
+static void etx_weights_synthetic(const CsrGraph *g, unsigned short *w) {
+  for(int u=0; u<g->n; u++) {
+    for(int c=g->offsets[u]; c<g->offsets[u + 1]; c++) {
+      int v = g->targets[c];
+      unsigned int a = u < v ? u : v, b = u < v ? v : u;
+      w[c] = ETX_SCALE + hash_u32(a * 2654435761U ^ b) % (ETX_MAX - ETX_SCALE + 1);
+    }
+  }
+}
+
+/* Dial's algorithm from src over integer weights in [1, ETX_MAX]. Every
+ * pending distance lies within ETX_MAX of the one being settled, so
+ * ETX_MAX + 1 circular buckets suffice. Buckets are intrusive doubly
+ * linked lists, giving O(1) decrease-key, and the run is O(m + D)
+ * for largest distance D. Ties in distance go to the lowest-id parent,
+ * so the tree does not depend on settle order. The walk is resumable:
+ * dial_run() stops after a given number of steps (a bucket visited or
+ * an adjacency entry relaxed) and carries on from there next call. */
+typedef struct {
+  const CsrGraph *g;
+  const unsigned short *w;
+  int *dist, *parent;
+  int *next, *prev;
+  size_t bytes;
+  int head[ETX_MAX + 1];
+  long cur;                /* bucket being emptied */
+  int pending, reached;
+  int u, c;                /* node being settled and its next entry */
+} DialRun;
+
+/* Starts a run from src; returns -1 when out of memory */
+static int dial_begin(DialRun *d, const CsrGraph *g, const unsigned short *w, int src,
+                      int *dist, int *parent) {
+  int n = g->n;
+  d->g = g;
+  d->w = w;
+  d->dist = dist;
+  d->parent = parent;
+  d->bytes = sizeof(int) * (size_t)n;
+  d->next = numa_alloc(d->bytes);
+  d->prev = numa_alloc(d->bytes);
+  d->reached = 0;
+  if(!d->next || !d->prev) {
+    LOG_ERR("Out of memory for %d-node shortest paths\n", n);
+    numa_free(d->next, d->bytes);
+    numa_free(d->prev, d->bytes);
+    d->next = d->prev = NULL;
+    return -1;
+  }
+
+  for(int i=0; i<n; i++) {
+    dist[i] = SSSP_UNREACHED;
+    parent[i] = -1;
+  }
+  for(int b=0; b<=ETX_MAX; b++) d->head[b] = -1;
+
+  dist[src] = 0;
+  d->head[0] = src;
+  d->next[src] = d->prev[src] = -1;
+  d->pending = 1;
+  d->cur = 0;
+  d->u = -1;
+  return 0;
+}
+
+/* Up to steps steps of the walk; returns 1 once every reachable node
+ * is settled */
+static int dial_run(DialRun *d, long steps) {
+  const CsrGraph *g = d->g;
+  int *dist = d->dist, *parent = d->parent, *next = d->next, *prev = d->prev;
+  int *head = d->head;
+
+  while(d->pending > 0 || d->u >= 0) {
+    if(steps-- <= 0) return 0;
+    if(d->u < 0) {
+      int b = (int)(d->cur % (ETX_MAX + 1));
+      if(head[b] == -1) {
+        d->cur++;
+        continue;
+      }
+      int u = head[b];
+      head[b] = next[u];
+      if(next[u] != -1) prev[next[u]] = -1;
+      d->pending--;
+      d->reached++;
+      d->u = u;
+      d->c = g->offsets[u];
+      continue;
+    }
+
+    int u = d->u;
+    if(d->c == g->offsets[u + 1]) {
+      d->u = -1;
+      continue;
+    }
+    int c = d->c++;
+    int v = g->targets[c];
+    int nd = dist[u] + d->w[c];
+    if(nd < dist[v]) {
+      if(dist[v] != SSSP_UNREACHED) {
+        /* Unlink from its old bucket */
+        if(prev[v] != -1) next[prev[v]] = next[v];
+        else head[dist[v] % (ETX_MAX + 1)] = next[v];
+        if(next[v] != -1) prev[next[v]] = prev[v];
+      } else {
+        d->pending++;
+      }
+      dist[v] = nd;
+      parent[v] = u;
+      int nb = nd % (ETX_MAX + 1);
+      prev[v] = -1;
+      next[v] = head[nb];
+      if(head[nb] != -1) prev[head[nb]] = v;
+      head[nb] = v;
+    } else if(nd == dist[v] && u < parent[v]) {
+      parent[v] = u;
+    }
+  }
+  return 1;
+}
+
+static void dial_end(DialRun *d) {
+  numa_free(d->next, d->bytes);
+  numa_free(d->prev, d->bytes);
+  d->next = d->prev = NULL;
+}
+
+/* The whole walk at once. Returns the number of nodes reached, or -1
+ * when out of memory. */
+int sssp_dial(const CsrGraph *g, const unsigned short *w, int src, int *dist, int *parent) {
+  DialRun d;
+  if(dial_begin(&d, g, w, src, dist, parent) < 0) return -1;
+  dial_run(&d, LONG_MAX);
+  dial_end(&d);
+  return d.reached;
+}
+
+/* ----------------- Routing load ------------------ */
+
+/* Per-node forwarding load when every mote sends one packet to root 0
+ * along a shortest-hop path. One thread team builds the BFS levels
+ * frontier by frontier (a node is claimed by compare-and-swap on its
+ * level), gives each node the lowest-id neighbour one level up as its
+ * parent, then sums subtree sizes from the deepest level up. Levels and
+ * parents do not depend on which thread claimed what, so the loads are
+ * the same for any thread count. */
+typedef struct {
+  const CsrGraph *g;
+  int *level;
+  int *parent;
+  int *load;               /* packets through the node, its own included */
+  int *order;              /* BFS order, one frontier after another */
+  int *level_start;        /* levels + 1 entries into order */
+  int levels;
+  int order_len;
+  int head, tail;
+  pthread_barrier_t barrier;
+  int barrier_threads;     /* 0 while the barrier is not initialised */
+} LoadJob;
+
+typedef struct {
+  int reached;
+  int max_load;            /* forwarded packets, own excluded */
+  int max_node;
+  double mean_load;        /* over nodes that forward anything */
+  double mean_hops;
+  int forwarders;
+  double mean_rank;        /* ETX rank, over reached non-root nodes */
+  int max_rank;
+} LoadStats;
+
+/* Below this many nodes the team costs more than the walk */
+#define PARALLEL_LOAD_THRESHOLD 256
+
+static int load_initial[MAX_NODES];
+static int load_final[MAX_NODES];
+static int rank_initial[MAX_NODES];
+static int rank_final[MAX_NODES];
+static int rpl_parent_initial[MAX_NODES];
+static int rpl_parent_final[MAX_NODES];
+static LoadStats load_stats[2];
+
+/* Scratch of the walk: BFS levels (then ETX distances), parents,
+ * subtree packet counts, BFS order and ETX weights */
+static int load_level[MAX_NODES], load_parent[MAX_NODES], load_total[MAX_NODES];
+static int load_order[MAX_NODES], load_level_start[MAX_NODES + 2];
+static unsigned short load_etx[MAX_NODES * MAX_NEIGHBORS];
+
+/* Running sums behind the means of a LoadStats */
+typedef struct {
+  long hops, forwarded, ranks;
+  int ranked;
+} LoadTally;
+
+static void routing_load_worker(int tid, int nthreads, void *arg) {
+  LoadJob *j = arg;
+  const CsrGraph *g = j->g;
+  long lo, hi;
+
+  for(int d=0; ; d++) {
+    thread_range(tid, nthreads, j->tail - j->head, &lo, &hi);
+    for(long f=j->head+lo; f<j->head+hi; f++) {
+      int u = j->order[f];
+      for(int c=g->offsets[u]; c<g->offsets[u + 1]; c++) {
+        int v = g->targets[c], unseen = -1;
+        if(__atomic_load_n(&j->level[v], __ATOMIC_RELAXED) == -1 &&
+           __atomic_compare_exchange_n(&j->level[v], &unseen, d + 1, 0,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+          j->order[__atomic_fetch_add(&j->order_len, 1, __ATOMIC_RELAXED)] = v;
+        }
+      }
+    }
+    pthread_barrier_wait(&j->barrier);
+    if(tid == 0) {
+      j->head = j->tail;
+      j->tail = j->order_len;
+      j->level_start[++j->levels] = j->head;
+    }
+    pthread_barrier_wait(&j->barrier);
+    if(j->head == j->tail) break;
+  }
+
+  thread_range(tid, nthreads, g->n, &lo, &hi);
+  for(long v=lo; v<hi; v++) {
+    j->parent[v] = -1;
+    j->load[v] = j->level[v] >= 0 ? 1 : 0;
+    if(j->level[v] <= 0) continue;
+    for(int c=g->offsets[v]; c<g->offsets[v + 1]; c++) {
+      int w = g->targets[c];
+      if(j->level[w] == j->level[v] - 1 && (j->parent[v] == -1 || w < j->parent[v])) {
+        j->parent[v] = w;
+      }
+    }
+  }
+  pthread_barrier_wait(&j->barrier);
+
+  for(int d=j->levels-1; d>=1; d--) {
+    int first = j->level_start[d], count = j->level_start[d + 1] - first;
+    thread_range(tid, nthreads, count, &lo, &hi);
+    for(long f=first+lo; f<first+hi; f++) {
+      int v = j->order[f];
+      __atomic_fetch_add(&j->load[j->parent[v]], j->load[v], __ATOMIC_RELAXED);
+    }
+    pthread_barrier_wait(&j->barrier);
+  }
+}
+
+/* Resets the walk to root 0 alone, for a team of nthreads */
+static void routing_load_prepare(void *arg, int nthreads) {
+  LoadJob *j = arg;
+  for(int i=0; i<j->g->n; i++) j->level[i] = -1;
+  j->level[0] = 0;
+  j->order[0] = 0;
+  j->order_len = 1;
+  j->levels = 0;
+  j->head = 0;
+  j->tail = 1;
+  j->level_start[0] = 0;
+
+  if(j->barrier_threads > 0) pthread_barrier_destroy(&j->barrier);
+  pthread_barrier_init(&j->barrier, NULL, nthreads);
+  j->barrier_threads = nthreads;
+}
+
+/* Empties load[], rank[] and rpl_parent[] for every id, so ids past
+ * n_nodes, such as relays placed later, read as unreached */
+static void load_clear(int *load, int *rank, int *rpl_parent, LoadStats *st, LoadTally *t) {
+  memset(st, 0, sizeof(*st));
+  memset(t, 0, sizeof(*t));
+  for(int v=0; v<MAX_NODES; v++) {
+    load[v] = 0;
+    rank[v] = rpl_parent[v] = -1;
+  }
+}
+
+/* Forwarding load of node v from the subtree counts */
+static void load_tally_node(int *load, LoadStats *st, LoadTally *t, int v) {
+  load[v] = load_total[v] > 0 ? load_total[v] - 1 : 0;
+  if(load_level[v] < 0) return;
+  st->reached++;
+  t->hops += load_level[v];
+  if(v != 0 && load[v] > 0) {
+    st->forwarders++;
+    t->forwarded += load[v];
+  }
+  if(v != 0 && load[v] > st->max_load) {
+    st->max_load = load[v];
+    st->max_node = v;
+  }
+}
+
+/* ETX rank of node v from the distances Dial left in load_level */
+static void rank_tally_node(int *rank, LoadStats *st, LoadTally *t, int v) {
+  if(load_level[v] == SSSP_UNREACHED) return;
+  rank[v] = RPL_ROOT_RANK + load_level[v];
+  if(v == 0) return;
+  t->ranks += rank[v];
+  t->ranked++;
+  if(rank[v] > st->max_rank) st->max_rank = rank[v];
+}
+
+static void load_tally_finish(LoadStats *st, const LoadTally *t) {
+  st->mean_hops = st->reached > 1 ? (double)t->hops / (st->reached - 1) : 0.0;
+  st->mean_load = st->forwarders > 0 ? (double)t->forwarded / st->forwarders : 0.0;
+  if(t->ranked > 0) st->mean_rank = (double)t->ranks / t->ranked;
+}
+
+/* Fills load[] (packets forwarded by each node, own excluded) for the
+ * current graph, rank[] and rpl_parent[] from the ETX shortest-path
+ * tree (-1 where unreached), and summarises them in st. Ids past
+ * n_nodes, such as relays placed later, read as unreached. */
+void routing_load(int *load, int *rank, int *rpl_parent, LoadStats *st) {
+  LoadTally t;
+  CsrGraph g;
+  csr_from_graph(&g);
+
+  LoadJob j;
+  memset(&j, 0, sizeof(j));
+  j.g = &g;
+  j.level = load_level;
+  j.parent = load_parent;
+  j.load = load_total;
+  j.order = load_order;
+  j.level_start = load_level_start;
+  load_clear(load, rank, rpl_parent, st, &t);
+  if(n_nodes == 0) return;
+
+  int threads = n_nodes >= PARALLEL_LOAD_THRESHOLD || force_parallel ? num_threads : 1;
+  autotune_run(TUNE_ROUTING_LOAD, n_nodes, (double)g.m / n_nodes, threads,
+               routing_load_worker, &j, routing_load_prepare);
+  pthread_barrier_destroy(&j.barrier);
+
+  for(int v=0; v<n_nodes; v++) load_tally_node(load, st, &t, v);
+
+  /* ETX ranks from the shortest-path tree, reusing the BFS scratch */
+  etx_weights_from_positions(&g, load_etx);
+  if(sssp_dial(&g, load_etx, 0, load_level, rpl_parent) > 1) {
+    for(int v=0; v<n_nodes; v++) rank_tally_node(rank, st, &t, v);
+  }
+  load_tally_finish(st, &t);
+}
+
+/* routing_load() in bounded steps, for the cooperative mode. A step is
+ * one row of a per-node pass (CSR snapshot, parents, subtree sums,
+ * tallies, ETX weights, ranks) or one step of the BFS or Dial walk.
+ * The walk is sequential; levels and lowest-id parents do not depend on
+ * the visiting order, so the results are the team's. */
+typedef enum {
+  LOAD_CSR = 0, LOAD_BFS, LOAD_PARENTS, LOAD_SUMS, LOAD_TALLY,
+  LOAD_WEIGHTS, LOAD_DIAL, LOAD_RANKS, LOAD_DONE
+} load_stage_t;
+
+typedef struct {
+  int *load, *rank, *rpl_parent;
+  LoadStats *st;
+  LoadTally t;
+  CsrGraph g;
+  load_stage_t stage;
+  int row;                 /* next row of a per-node pass */
+  int head, tail;          /* BFS queue in load_order */
+  int u, c;                /* node being expanded and its next entry */
+  DialRun dial;
+} LoadRun;
+
+void load_begin(LoadRun *r, int *load, int *rank, int *rpl_parent, LoadStats *st) {
+  r->load = load;
+  r->rank = rank;
+  r->rpl_parent = rpl_parent;
+  r->st = st;
+  load_clear(load, rank, rpl_parent, st, &r->t);
+  r->stage = n_nodes == 0 ? LOAD_DONE : LOAD_CSR;
+  r->row = 0;
+}
+
+/* Up to steps steps; returns 1 once load[], rank[], rpl_parent[] and
+ * the summary are complete */
+int load_run(LoadRun *r, long steps) {
+  const CsrGraph *g = &r->g;
+
+  while(r->stage != LOAD_DONE) {
+    if(steps <= 0) return 0;
+    switch(r->stage) {
+    case LOAD_CSR:
+      csr_snapshot_rows(r->row, r->row + 1);
+      steps--;
+      if(++r->row < n_nodes) break;
+      csr_snapshot(&r->g);
+      for(int i=0; i<n_nodes; i++) load_level[i] = -1;
+      load_level[0] = 0;
+      load_order[0] = 0;
+      r->head = 0;
+      r->tail = 1;
+      r->u = -1;
+      r->stage = LOAD_BFS;
+      break;
+
+    case LOAD_BFS:
+      steps--;
+      if(r->u < 0) {
+        if(r->head == r->tail) {
+          r->row = 0;
+          r->stage = LOAD_PARENTS;
+          break;
+        }
+        r->u = load_order[r->head++];
+        r->c = g->offsets[r->u];
+      } else if(r->c == g->offsets[r->u + 1]) {
+        r->u = -1;
+      } else {
+        int v = g->targets[r->c++];
+        if(load_level[v] == -1) {
+          load_level[v] = load_level[r->u] + 1;
+          load_order[r->tail++] = v;
+        }
+      }
+      break;
+
+    case LOAD_PARENTS: {
+      int v = r->row;
+      load_parent[v] = -1;
+      load_total[v] = load_level[v] >= 0 ? 1 : 0;
+      if(load_level[v] > 0) {
+        for(int c=g->offsets[v]; c<g->offsets[v + 1]; c++) {
+          int w = g->targets[c];
+          if(load_level[w] == load_level[v] - 1 &&
+             (load_parent[v] == -1 || w < load_parent[v])) {
+            load_parent[v] = w;
+          }
+        }
+      }
+      steps--;
+      if(++r->row < n_nodes) break;
+      r->row = r->tail - 1;
+      r->stage = LOAD_SUMS;
+      break;
+    }
+
+    case LOAD_SUMS:
+      /* Children come after their parent in BFS order */
+      if(r->row >= 1) {
+        int v = load_order[r->row--];
+        load_total[load_parent[v]] += load_total[v];
+        steps--;
+        break;
+      }
+      r->row = 0;
+      r->stage = LOAD_TALLY;
+      break;
+
+    case LOAD_TALLY:
+      load_tally_node(r->load, r->st, &r->t, r->row);
+      steps--;
+      if(++r->row < n_nodes) break;
+      r->row = 0;
+      r->stage = LOAD_WEIGHTS;
+      break;
+
+    case LOAD_WEIGHTS:
+      etx_weight_rows(g, load_etx, r->row, r->row + 1);
+      steps--;
+      if(++r->row < n_nodes) break;
+      if(dial_begin(&r->dial, g, load_etx, 0, load_level, r->rpl_parent) < 0) {
+        load_tally_finish(r->st, &r->t);
+        r->stage = LOAD_DONE;
+        break;
+      }
+      r->stage = LOAD_DIAL;
+      break;
+
+    case LOAD_DIAL: {
+      long budget = steps;
+      steps = 0;
+      if(!dial_run(&r->dial, budget)) break;
+      dial_end(&r->dial);
+      r->row = 0;
+      r->stage = r->dial.reached > 1 ? LOAD_RANKS : LOAD_DONE;
+      if(r->stage == LOAD_DONE) load_tally_finish(r->st, &r->t);
+      break;
+    }
+
+    case LOAD_RANKS:
+      rank_tally_node(r->rank, r->st, &r->t, r->row);
+      steps--;
+      if(++r->row < n_nodes) break;
+      load_tally_finish(r->st, &r->t);
+      r->stage = LOAD_DONE;
+      break;
+
+    default:
+      break;
+    }
+  }
+  return 1;
+}
+
+void print_routing_load(void) {
+  const LoadStats *a = &load_stats[0], *b = &load_stats[1];
+  printf("Routing load toward root 0 (shortest hops, one packet per mote;\n"
+         "ranks from the ETX shortest-path tree):\n");
+  printf("  %-24s %10s %10s\n", "", "initial", "final");
+  printf("  %-24s %10d %10d\n", "motes reaching root", a->reached, b->reached);
+  printf("  %-24s %10.2f %10.2f\n", "mean hops", a->mean_hops, b->mean_hops);
+  printf("  %-24s %10.1f %10.1f\n", "mean ETX rank", a->mean_rank, b->mean_rank);
+  printf("  %-24s %10d %10d\n", "max ETX rank", a->max_rank, b->max_rank);
+  printf("  %-24s %10d %10d\n", "forwarding motes", a->forwarders, b->forwarders);
+  printf("  %-24s %10.1f %10.1f\n", "mean forwarded", a->mean_load, b->mean_load);
+  printf("  %-24s %10d %10d\n", "max forwarded (non-root)", a->max_load, b->max_load);
+  printf("  %-24s %10d %10d\n", "  at mote", a->max_node, b->max_node);
+  printf("  %-24s %10d %10d\n", "  that mote, other graph",
+         load_final[a->max_node], load_initial[b->max_node]);
+  if(a->max_load > 0) {
+    printf("  hotspot relief: %.1f%%\n", 100.0 * (a->max_load - b->max_load) / a->max_load);
+  }
+  printf("\n");
+}
+
+/* ----------------- Hop depth ------------------ */
+
+/* Hop depth from root 0 in the original and the healed graph, from one
+ * fused BFS over the healed graph. Each node carries two bits, one per
+ * graph; an adjacency entry passes on both bits when the link was in the
+ * original graph and only the healed bit when it was added. Where the
+ * two depths agree, which is most of the network, the node is expanded
+ * once for both graphs; where they differ it is expanded twice. Relays
+ * exist only in the healed graph. */
+#define HOP_BEFORE 1
+#define HOP_AFTER 2
+
+static int hop_before[MAX_NODES];
+static int hop_after[MAX_NODES];
+static long hop_scans;               /* adjacency entries read */
+static long hop_separate;            /* the same for two plain BFS passes */
+
+static unsigned char hop_bits[MAX_NODES * MAX_NEIGHBORS];
+static unsigned char hop_seen[MAX_NODES], hop_pending[2][MAX_NODES];
+static int hop_frontier[2][MAX_NODES];
+
+/* The fused BFS, resumable: hop_run() stops after a given number of
+ * steps (a frontier node taken or an adjacency entry read) */
+typedef struct {
+  const CsrGraph *g;
+  const unsigned char *bits;
+  int *before, *after;
+  int depth, cur, len, next_len, i;
+  int u, c;                /* node being expanded and its next entry */
+  unsigned char f;         /* the graphs it is expanded for */
+  long scans;
+} HopRun;
+
+/* bits[c] says in which graphs adjacency entry c exists; depths are -1
+ * where a node is not reached */
+static void hop_begin(HopRun *h, const CsrGraph *g, const unsigned char *bits,
+                      int *before, int *after) {
+  h->g = g;
+  h->bits = bits;
+  h->before = before;
+  h->after = after;
+  h->depth = 1;
+  h->cur = 0;
+  h->len = h->next_len = h->i = 0;
+  h->u = -1;
+  h->scans = 0;
+
+  for(int v=0; v<g->n; v++) {
+    before[v] = after[v] = -1;
+    hop_seen[v] = hop_pending[0][v] = hop_pending[1][v] = 0;
+  }
+  if(g->n == 0) return;
+
+  hop_seen[0] = hop_pending[0][0] = HOP_BEFORE | HOP_AFTER;
+  before[0] = after[0] = 0;
+  hop_frontier[0][h->len++] = 0;
+}
+
+/* Up to steps steps; returns 1 once both depths are final */
+static int hop_run(HopRun *h, long steps) {
+  const CsrGraph *g = h->g;
+  int cur = h->cur;
+
+  for(;;) {
+    if(h->u < 0) {
+      if(h->i == h->len) {
+        if(h->next_len == 0) return 1;
+        h->cur = cur ^= 1;
+        h->len = h->next_len;
+        h->next_len = 0;
+        h->i = 0;
+        h->depth++;
+      }
+      if(steps-- <= 0) return 0;
+      h->u = hop_frontier[cur][h->i++];
+      h->f = hop_pending[cur][h->u];
+      hop_pending[cur][h->u] = 0;
+      h->c = g->offsets[h->u];
+      continue;
+    }
+    if(h->c == g->offsets[h->u + 1]) {
+      h->u = -1;
+      continue;
+    }
+    if(steps-- <= 0) return 0;
+
+    int c = h->c++;
+    int v = g->targets[c];
+    unsigned char b = h->f & h->bits[c] & ~hop_seen[v];
+    h->scans++;
+    if(!b) continue;
+    hop_seen[v] |= b;
+    if(b & HOP_BEFORE) h->before[v] = h->depth;
+    if(b & HOP_AFTER) h->after[v] = h->depth;
+    if(!hop_pending[cur ^ 1][v]) hop_frontier[cur ^ 1][h->next_len++] = v;
+    hop_pending[cur ^ 1][v] |= b;
+  }
+}
+
+/* Depths from one fused pass; returns the adjacency entries read */
+long fused_hop_depths(const CsrGraph *g, const unsigned char *bits,
+                      int *before, int *after) {
+  HopRun h;
+  hop_begin(&h, g, bits, before, after);
+  hop_run(&h, LONG_MAX);
+  return h.scans;
+}
+
+/* hop_bits of the adjacency entries of nodes lo .. hi-1; returns how
+ * many of them the original graph has */
+static long hop_bit_rows(const CsrGraph *g, int lo, int hi) {
+  long original = 0;
+  for(int u=lo; u<hi; u++) {
+    for(int c=g->offsets[u]; c<g->offsets[u + 1]; c++) {
+      hop_bits[c] = redundant_edge[u][g->targets[c]] ? HOP_AFTER : HOP_BEFORE | HOP_AFTER;
+      if(hop_bits[c] & HOP_BEFORE) original++;
+    }
+  }
+  return original;
+}
+
+void hop_depths_compare(void) {
+  CsrGraph g;
+  csr_from_graph(&g);
+
+  hop_separate = g.m + hop_bit_rows(&g, 0, g.n);
+  hop_scans = fused_hop_depths(&g, hop_bits, hop_before, hop_after);
+}
+
+void print_hop_report(void) {
+  int max_depth = 0, closer = 0, best_gain = 0, best_node = -1;
+  int lower_rank = 0;
+  long gain = 0, rank_gain = 0;
+  static int count_before[MAX_NODES], count_after[MAX_NODES];
+
+  for(int v=0; v<n_nodes; v++) count_before[v] = count_after[v] = 0;
+  for(int v=0; v<n_nodes; v++) {
+    if(hop_before[v] >= 0) count_before[hop_before[v]]++;
+    if(hop_after[v] >= 0) count_after[hop_after[v]]++;
+    if(hop_before[v] > max_depth) max_depth = hop_before[v];
+    if(hop_after[v] > max_depth) max_depth = hop_after[v];
+    if(hop_before[v] < 0 || hop_after[v] < 0) continue;
+    int d = hop_before[v] - hop_after[v];
+    if(d > 0) {
+      closer++;
+      gain += d;
+      if(d > best_gain) {
+        best_gain = d;
+        best_node = v;
+      }
+    }
+    if(rank_initial[v] >= 0 && rank_final[v] >= 0 && rank_final[v] < rank_initial[v]) {
+      lower_rank++;
+      rank_gain += rank_initial[v] - rank_final[v];
+    }
+  }
+
+  printf("Hop depth from root 0 (motes per depth):\n");
+  printf("  %5s %8s %8s\n", "hops", "initial", "final");
+  for(int h=0; h<=max_depth; h++) {
+    printf("  %5d %8d %8d\n", h, count_before[h], count_after[h]);
+  }
+  printf("  motes closer to root:   %d", closer);
+  if(closer > 0) {
+    printf(" (mean %.2f hops, best %d at mote %d)", (double)gain / closer, best_gain, best_node);
+  }
+  printf("\n  motes with lower rank:   %d", lower_rank);
+  if(lower_rank > 0) printf(" (mean %.1f)", (double)rank_gain / lower_rank);
+  printf("\n  fused BFS: %ld adjacency reads for both graphs (two passes: %ld)\n\n",
+         hop_scans, hop_separate);
+}
+
+/* ----------------- Versioned graph ------------------ */
+
+/* Immutable graph version: a base CSR shared by consecutive versions,
+ * the links added since that base as an overlay, and the cut vertices
+ * of the whole. The writer never changes a published version; it builds
+ * the next one, swaps gv_current and retires the old one. Once the
+ * overlay passes VERSION_COMPACT_LINKS it is folded into a new base, so
+ * a batch normally costs O(links) to copy plus one analysis. */
+#define VERSION_COMPACT_LINKS 2048
+
+typedef struct GraphVersion {
+  long id;
+  CsrGraph base;
+  size_t offs_bytes;
+  size_t tgt_bytes;
+  int frees_base;          /* set on the last version using base */
+  Edge *links;             /* links added since base */
+  int nlinks;
+  OverlayGraph overlay;
+  char *cut;
+  int cut_count;
+  long retire_epoch;
+  struct GraphVersion *next_retired;
+} GraphVersion;
+
+/* Epoch-based reclamation. A reader announces the global epoch before
+ * loading gv_current and clears it when done. A version retired at
+ * epoch E is freed once every announced epoch is above E: those readers
+ * read the epoch after the swap, so they loaded a newer version. */
+typedef struct {
+  long epoch;              /* 0 while not reading */
+  char pad[64 - sizeof(long)];
+} ReaderSlot;
+
+static GraphVersion *gv_current = NULL;
+static long gv_epoch = 1;
+static ReaderSlot reader_slot[MAX_CPUS];
+static GraphVersion *gv_retired = NULL;   /* writer only */
+static int gv_pending = 0;
+static int gv_pending_peak = 0;
+static long gv_reclaimed = 0;
+
+static inline const GraphVersion *version_enter(int tid) {
+  __atomic_store_n(&reader_slot[tid].epoch,
+                   __atomic_load_n(&gv_epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+  return __atomic_load_n(&gv_current, __ATOMIC_SEQ_CST);
+}
+
+static inline void version_exit(int tid) {
+  __atomic_store_n(&reader_slot[tid].epoch, 0, __ATOMIC_RELEASE);
+}
+
+static inline int version_degree(const GraphVersion *v, int u) {
+  int d = v->base.offsets[u + 1] - v->base.offsets[u];
+  for(int j=overlay_first(&v->overlay, u); j<v->overlay.k && v->overlay.delta[j].u == u; j++) d++;
+  return d;
+}
+
+static void version_free(GraphVersion *v) {
+  overlay_free(&v->overlay);
+  free(v->links);
+  free(v->cut);
+  if(v->frees_base) {
+    numa_free((void *)v->base.offsets, v->offs_bytes);
+    numa_free((void *)v->base.targets, v->tgt_bytes);
+  }
+  free(v);
+}
+
+/* Analyses v over its base and overlay */
+static int version_analyse(GraphVersion *v) {
+  v->cut = malloc(v->base.n);
+  if(!v->cut || overlay_build(&v->overlay, &v->base, v->links, v->nlinks) != 0) return -1;
+  v->cut_count = overlay_cut_vertices(&v->overlay, v->cut);
+  return v->cut_count < 0 ? -1 : 0;
+}
+
+/* First version, taking ownership of numa_alloc()ed CSR arrays */
+GraphVersion *version_create(const CsrGraph *g, size_t offs_bytes, size_t tgt_bytes) {
+  GraphVersion *v = calloc(1, sizeof(GraphVersion));
+  if(!v) return NULL;
+  v->base = *g;
+  v->offs_bytes = offs_bytes;
+  v->tgt_bytes = tgt_bytes;
+  if(version_analyse(v) != 0) {
+    version_free(v);
+    return NULL;
+  }
+  return v;
+}
+
+/* Next version: cur plus batch[0..nbatch). cur is only read, so readers
+ * may keep using it. */
+GraphVersion *version_next(GraphVersion *cur, const Edge *batch, int nbatch) {
+  GraphVersion *v = calloc(1, sizeof(GraphVersion));
+  int compacted = 0;
+  if(!v) return NULL;
+  v->id = cur->id + 1;
+
+  if(cur->nlinks + nbatch <= VERSION_COMPACT_LINKS) {
+    v->base = cur->base;
+    v->offs_bytes = cur->offs_bytes;
+    v->tgt_bytes = cur->tgt_bytes;
+    v->links = malloc(sizeof(Edge) * (size_t)(cur->nlinks + nbatch + 1));
+    if(!v->links) goto fail;
+    memcpy(v->links, cur->links, sizeof(Edge) * (size_t)cur->nlinks);
+    memcpy(v->links + cur->nlinks, batch, sizeof(Edge) * (size_t)nbatch);
+    v->nlinks = cur->nlinks + nbatch;
+  } else {
+    /* Fold cur's overlay and the batch into a new base */
+    OverlayGraph o;
+    Edge *all = malloc(sizeof(Edge) * (size_t)(cur->nlinks + nbatch + 1));
+    int ok = all != NULL;
+    if(ok) {
+      memcpy(all, cur->links, sizeof(Edge) * (size_t)cur->nlinks);
+      memcpy(all + cur->nlinks, batch, sizeof(Edge) * (size_t)nbatch);
+      ok = overlay_build(&o, &cur->base, all, cur->nlinks + nbatch) == 0;
+    }
+    int *offs = NULL, *tgts = NULL;
+    if(ok) {
+      v->offs_bytes = sizeof(int) * ((size_t)cur->base.n + 1);
+      v->tgt_bytes = sizeof(int) * ((size_t)cur->base.m + o.k);
+      offs = numa_alloc(v->offs_bytes);
+      tgts = numa_alloc(v->tgt_bytes);
+      ok = offs && tgts;
+    }
+    if(ok) {
+      v->base.n = cur->base.n;
+      v->base.m = overlay_flatten(&o, offs, tgts);
+      v->base.offsets = offs;
+      v->base.targets = tgts;
+      compacted = 1;
+    } else {
+      numa_free(offs, v->offs_bytes);
+      numa_free(tgts, v->tgt_bytes);
+    }
+    if(all) overlay_free(&o);
+    free(all);
+    if(!ok) goto fail;
+  }
+
+  if(version_analyse(v) != 0) goto fail;
+  if(compacted) cur->frees_base = 1;
+  return v;
+
+fail:
+  LOG_ERR("Out of memory building graph version %ld\n", v->id);
+  v->frees_base = compacted;
+  version_free(v);
+  return NULL;
+}
+
+/* Frees retired versions no reader can still hold */
+static void version_reclaim(int nreaders) {
+  long min_epoch = LONG_MAX;
+  for(int t=0; t<nreaders; t++) {
+    long e = __atomic_load_n(&reader_slot[t].epoch, __ATOMIC_SEQ_CST);
+    if(e != 0 && e < min_epoch) min_epoch = e;
+  }
+
+  GraphVersion **pp = &gv_retired;
+  while(*pp) {
+    GraphVersion *v = *pp;
+    if(v->retire_epoch < min_epoch) {
+      *pp = v->next_retired;
+      version_free(v);
+      gv_pending--;
+      gv_reclaimed++;
+    } else {
+      pp = &v->next_retired;
+    }
+  }
+}
+
+/* Makes next the current version and retires the previous one. Reader
+ * slots [0, nreaders) are scanned for reclamation. */
+void version_publish(GraphVersion *next, int nreaders) {
+  GraphVersion *old = __atomic_exchange_n(&gv_current, next, __ATOMIC_SEQ_CST);
+  if(old) {
+    old->retire_epoch = __atomic_fetch_add(&gv_epoch, 1, __ATOMIC_SEQ_CST);
+    old->next_retired = gv_retired;
+    gv_retired = old;
+    if(++gv_pending > gv_pending_peak) gv_pending_peak = gv_pending;
+  }
+  version_reclaim(nreaders);
+}
+
+/* Drops every version once no reader is left */
+void version_shutdown(void) {
+  GraphVersion *cur = gv_current;
+  gv_current = NULL;
+  if(cur) {
+    cur->frees_base = 1;
+    cur->retire_epoch = 0;
+    cur->next_retired = gv_retired;
+    gv_retired = cur;
+    gv_pending++;
+  }
+  version_reclaim(0);
+}
+
+/* ----------------- NUMA benchmark ------------------ */
+
+typedef struct {
+  const int *data;
+  long n;
+  long sums[MAX_CPUS];
+} StreamJob;
+
+static void stream_worker(int tid, int nthreads, void *arg) {
+  StreamJob *j = arg;
+  long lo, hi, sum = 0;
+  thread_range(tid, nthreads, j->n, &lo, &hi);
+  for(long i=lo; i<hi; i++) sum += j->data[i];
+  j->sums[tid % MAX_CPUS] = sum;
+}
+
+/* Builds an n-node synthetic graph under each placement policy and
+ * measures streaming read bandwidth over the adjacency plus the
+ * parallel connectivity engine at 1 and num_threads threads. With the
+ * default policy the single generator thread first-touches everything,
+ * which is the remote-memory case the other two policies avoid. With
+ * --parts=K the engine also runs with its unions scheduled by
+ * label-propagation partition (partitioning itself is not timed). */
+void run_numa_benchmark(int n) {
+  detect_topology();
+  LOG_INFO("NUMA benchmark: %d nodes, %d threads, %d NUMA node(s), pin=%s\n",
+           n, num_threads, numa_nodes, pin_names[pin_policy]);
+
+  printf("\n%-11s %10s %10s %10s %10s %8s %10s\n",
+         "placement", "build ms", "GB/s", "cc 1T ms", "cc NT ms", "speedup", "cc part ms");
+
+  for(int pl=0; pl<3; pl++) {
+    size_t offs_bytes = sizeof(int) * ((size_t)n + 1);
+    int *offs = numa_alloc(offs_bytes);
+    if(!offs) {
+      LOG_ERR("Out of memory for %d-node benchmark\n", n);
+      return;
+    }
+    numa_place(offs, offs_bytes, (placement_t)pl, num_threads);
+
+    double start = get_time_ms();
+    int m = csr_synthetic_offsets(n, offs);
+
+    size_t tgt_bytes = sizeof(int) * (size_t)m;
+    size_t comp_bytes = sizeof(int) * (size_t)n;
+    int *tgts = numa_alloc(tgt_bytes);
+    int *comp = numa_alloc(comp_bytes);
+    int *cursor = malloc(offs_bytes);
+    if(!tgts || !comp || !cursor) {
+      LOG_ERR("Out of memory for %d-node benchmark\n", n);
+      numa_free(offs, offs_bytes);
+      numa_free(tgts, tgt_bytes);
+      numa_free(comp, comp_bytes);
+      free(cursor);
+      return;
+    }
+    numa_place(tgts, tgt_bytes, (placement_t)pl, num_threads);
+    numa_place(comp, comp_bytes, (placement_t)pl, num_threads);
+
+    memcpy(cursor, offs, offs_bytes);
+    csr_synthetic_targets(n, cursor, tgts);
+    free(cursor);
+    double t_build = get_time_ms() - start;
+
+    CsrGraph g = { n, m, offs, tgts };
+
+    StreamJob sj;
+    sj.data = tgts;
+    sj.n = m;
+    start = get_time_ms();
+    run_parallel(num_threads, stream_worker, &sj);
+    double t_stream = get_time_ms() - start;
+
+    start = get_time_ms();
+    int cc1 = parallel_components(&g, comp, 1);
+    double t_cc1 = get_time_ms() - start;
+
+    start = get_time_ms();
+    int ccn = parallel_components(&g, comp, num_threads);
+    double t_ccn = get_time_ms() - start;
+
+    if(cc1 != ccn) LOG_ERR("Component count mismatch: %d vs %d\n", cc1, ccn);
+
+    double t_ccp = -1.0;
+    if(hier_parts > 1 && hier_parts <= n) {
+      size_t start_bytes = sizeof(int) * ((size_t)hier_parts + 1);
+      int *part = numa_alloc(comp_bytes);
+      int *members = numa_alloc(comp_bytes);
+      int *member_start = numa_alloc(start_bytes);
+      int *scratch = malloc(start_bytes);
+      PartStats ps;
+      if(part && members && member_start && scratch &&
+         partition_graph(&g, PARTITION_LABEL_PROP, hier_parts, part, &ps) == 0) {
+        memset(member_start, 0, start_bytes);
+        partition_members(n, part, hier_parts, members, member_start, scratch);
+        start = get_time_ms();
+        int ccp = partitioned_components(&g, members, member_start, hier_parts, comp,
+                                         num_threads);
+        t_ccp = get_time_ms() - start;
+        if(ccp != cc1) LOG_ERR("Component count mismatch: %d vs %d\n", cc1, ccp);
+      }
+      numa_free(part, comp_bytes);
+      numa_free(members, comp_bytes);
+      numa_free(member_start, start_bytes);
+      free(scratch);
+    }
+
+    printf("%-11s %10.2f %10.2f %10.2f %10.2f %7.2fx ",
+           placement_names[pl], t_build,
+           t_stream > 0 ? tgt_bytes / (t_stream * 1e6) : 0.0,
+           t_cc1, t_ccn, t_ccn > 0 ? t_cc1 / t_ccn : 0.0);
+    if(t_ccp < 0) printf("%10s\n", "-");
+    else printf("%10.2f\n", t_ccp);
+
+    numa_free(offs, offs_bytes);
+    numa_free(tgts, tgt_bytes);
+    numa_free(comp, comp_bytes);
+  }
+  printf("\n");
+}
+
+/* ----------------- Optimal edge addition ------------------ */
+
+void identify_leaf_blocks(void) {
+  ensure_blocks();
+  num_leaf_blocks = 0;
+  memset(is_leaf_block, 0, sizeof(is_leaf_block));
+  
+  for(int b=0; b<num_blocks; b++) {
+    int cut_count = 0;
+    for(int i=0; i<block_size[b]; i++) {
+      int node = block_nodes[b][i];
+      if(is_cut[node]) cut_count++;
+    }
+    
+    if(cut_count == 1) {
+      is_leaf_block[b] = 1;
+      for(int i=0; i<block_size[b]; i++) {
+        if(is_cut[block_nodes[b][i]]) leaf_cut[num_leaf_blocks] = block_nodes[b][i];
+      }
+      leaf_blocks[num_leaf_blocks++] = b;
+    }
+  }
+}
+
+/* Lowest-id non-cut node of the block (lowest-id node if all are cut).
+ * Choosing by id rather than by position keeps the augmentation
+ * independent of the order the extraction emitted the block in. */
+int find_non_cut_in_block(int block) {
+  int best = -1, fallback = -1;
+  for(int i=0; i<block_size[block]; i++) {
+    int node = block_nodes[block][i];
+    if(!is_cut[node] && (best == -1 || node < best)) best = node;
+    if(fallback == -1 || node < fallback) fallback = node;
+  }
+  return best != -1 ? best : fallback;
+}
+
+/* ----------------- Energy-aware selection ------------------ */
+
+/* Expected radio energy of one more link at a mote, relative to a fresh
+ * battery: each neighbour costs listening and forwarding time, and a
+ * low battery makes every unit dearer. ENERGY_BATTERY_FLOOR keeps the
+ * cost finite for a nearly empty battery. */
+#define ENERGY_BATTERY_FLOOR 0.05
+
+static int planned_degree[MAX_NODES];
+
+static inline double link_energy_cost(int v, int deg) {
+  return (deg + 1) / (node_battery[v] + ENERGY_BATTERY_FLOOR);
+}
+
+/* One min-heap per leaf block over its non-cut nodes (its lowest-id
+ * node if every node is cut), keyed by link_energy_cost() at the
+ * planned degree. Non-cut nodes belong to a single block, so the heaps
+ * are disjoint slices of one array and can be built in parallel. */
+static int energy_heap[MAX_NODES + MAX_BLOCKS];
+static double energy_key[MAX_NODES + MAX_BLOCKS];
+static int energy_start[MAX_BLOCKS];
+static int energy_len[MAX_BLOCKS];
+static char energy_drawn = 0;      /* a plan has taken from the heaps */
+
+static void energy_sift_down(int *h, double *k, int len, int i) {
+  for(;;) {
+    int c = 2 * i + 1;
+    if(c >= len) return;
+    if(c + 1 < len && (k[c + 1] < k[c] || (k[c + 1] == k[c] && h[c + 1] < h[c]))) c++;
+    if(k[i] < k[c] || (k[i] == k[c] && h[i] < h[c])) return;
+    int th = h[i]; h[i] = h[c]; h[c] = th;
+    double tk = k[i]; k[i] = k[c]; k[c] = tk;
+    i = c;
+  }
+}
+
+/* Sizes each leaf's slice; linear in the total leaf block size */
+static void energy_layout(void) {
+  int pos = 0;
+  for(int i=0; i<num_leaf_blocks; i++) {
+    int b = leaf_blocks[i], count = 0;
+    for(int j=0; j<block_size[b]; j++) if(!is_cut[block_nodes[b][j]]) count++;
+    energy_start[i] = pos;
+    energy_len[i] = count > 0 ? count : 1;
+    pos += energy_len[i];
+  }
+}
+
+/* Fills and heapifies leaf i's slice at current degrees */
+static void energy_build_heap(int i) {
+  int *h = &energy_heap[energy_start[i]];
+  double *k = &energy_key[energy_start[i]];
+  int b = leaf_blocks[i], len = 0;
+
+  for(int j=0; j<block_size[b]; j++) {
+    int v = block_nodes[b][j];
+    if(!is_cut[v]) h[len++] = v;
+  }
+  if(len == 0) h[len++] = find_non_cut_in_block(b);
+
+  for(int j=0; j<len; j++) {
+    planned_degree[h[j]] = degree[h[j]];
+    k[j] = link_energy_cost(h[j], degree[h[j]]);
+  }
+  for(int j=len/2-1; j>=0; j--) energy_sift_down(h, k, len, j);
+  leaf_candidate[i] = h[0];
+}
+
+static void energy_heap_worker(int tid, int nthreads, void *arg) {
+  long lo, hi;
+  (void)arg;
+  thread_range(tid, nthreads, num_leaf_blocks, &lo, &hi);
+  for(long i=lo; i<hi; i++) energy_build_heap((int)i);
+}
+
+/* Restores every heap to current degrees, so a plan can be redrawn.
+ * Heaps nothing has taken from yet are left as select_leaf_candidates()
+ * built them. */
+static void energy_reset(void) {
+  if(!energy_drawn) return;
+  for(int i=0; i<num_leaf_blocks; i++) energy_build_heap(i);
+  energy_drawn = 0;
+}
+
+/* Cheapest endpoint of leaf i; its planned degree goes up by one, so a
+ * second link from the same leaf weighs the extra neighbour */
+static int energy_take(int i) {
+  int *h = &energy_heap[energy_start[i]];
+  double *k = &energy_key[energy_start[i]];
+  int v = h[0];
+  energy_drawn = 1;
+  planned_degree[v]++;
+  k[0] = link_energy_cost(v, planned_degree[v]);
+  energy_sift_down(h, k, energy_len[i], 0);
+  return v;
+}
+
+/* Below this many leaves thread start-up costs more than the scan */
+#define PARALLEL_LEAF_THRESHOLD 256
+
+static void leaf_candidate_worker(int tid, int nthreads, void *arg) {
+  long lo, hi;
+  (void)arg;
+  thread_range(tid, nthreads, num_leaf_blocks, &lo, &hi);
+  for(long i=lo; i<hi; i++) leaf_candidate[i] = find_non_cut_in_block(leaf_blocks[i]);
+}
+
+/* Candidate search for every leaf block. Each leaf's candidate depends
+ * only on its own block and is_cut, neither of which changes while
+ * edges are added, so leaves are split across threads and the pairing
+ * loop merges them in leaf order: the plan is the same for any thread
+ * count. */
+void select_leaf_candidates(void) {
+  int threads = num_leaf_blocks >= PARALLEL_LEAF_THRESHOLD || force_parallel ? num_threads : 1;
+  long nodes = 0;
+  for(int i=0; i<num_leaf_blocks; i++) nodes += block_size[leaf_blocks[i]];
+  double density = num_leaf_blocks > 0 ? (double)nodes / num_leaf_blocks : 0.0;
+
+  if(select_mode == SELECT_ENERGY) {
+    energy_layout();
+    energy_drawn = 0;
+    autotune_run(TUNE_ENERGY_HEAPS, num_leaf_blocks, density, threads,
+                 energy_heap_worker, NULL, NULL);
+  } else {
+    autotune_run(TUNE_LEAF_CANDIDATES, num_leaf_blocks, density, threads,
+                 leaf_candidate_worker, NULL, NULL);
+  }
+}
+
+/* ----------------- Spatial leaf pairing ------------------ */
+
+/* Hilbert curve index of (x, y) on a 2^16 x 2^16 grid */
+static unsigned int hilbert_index(unsigned int x, unsigned int y) {
+  unsigned int d = 0;
+  for(unsigned int s=1U << 15; s>0; s>>=1) {
+    unsigned int rx = (x & s) ? 1 : 0;
+    unsigned int ry = (y & s) ? 1 : 0;
+    d += s * s * ((3 * rx) ^ ry);
+    if(ry == 0) {
+      if(rx == 1) {
+        x = s - 1 - x;
+        y = s - 1 - y;
+      }
+      unsigned int t = x; x = y; y = t;
+    }
+  }
+  return d;
+}
+
+typedef struct {
+  unsigned int key;
+  int leaf;
+} LeafKey;
+
+static int compare_leaf_keys(const void *a, const void *b) {
+  const LeafKey *ka = a, *kb = b;
+  if(ka->key != kb->key) return ka->key < kb->key ? -1 : 1;
+  return ka->leaf - kb->leaf;
+}
+
+static double pairing_cost(int start) {
+  double cost = 0.0;
+  for(int i=start; i+1<num_leaf_blocks; i+=2) {
+    cost += node_distance(leaf_candidate[leaf_order[i]], leaf_candidate[leaf_order[i + 1]]);
+  }
+  return cost;
+}
+
+/* Orders leaves along a Hilbert curve through their candidates, so that
+ * consecutive leaves are spatial neighbours and 0-1, 2-3, ... pairing
+ * is short: O(k log k) instead of O(k^2) matching. Two fix-ups keep it
+ * useful for biconnectivity: a pair whose leaves hang off the same cut
+ * vertex is split by swapping in the next leaf (such a link leaves that
+ * cut vertex in place), and the curve is rotated by one when that
+ * pairing is shorter. */
+void plan_spatial_pairing(void) {
+  static LeafKey keys[MAX_BLOCKS];
+  int k = num_leaf_blocks;
+  if(k == 0) return;
+
+  double min_x = node_x[0], max_x = node_x[0], min_y = node_y[0], max_y = node_y[0];
+  for(int i=0; i<n_nodes; i++) {
+    if(node_x[i] < min_x) min_x = node_x[i];
+    if(node_x[i] > max_x) max_x = node_x[i];
+    if(node_y[i] < min_y) min_y = node_y[i];
+    if(node_y[i] > max_y) max_y = node_y[i];
+  }
+  double span = (max_x - min_x > max_y - min_y) ? max_x - min_x : max_y - min_y;
+  double scale = span > 0 ? 65535.0 / span : 0.0;
+
+  for(int i=0; i<k; i++) {
+    int c = leaf_candidate[i];
+    keys[i].key = hilbert_index((unsigned int)((node_x[c] - min_x) * scale),
+                                (unsigned int)((node_y[c] - min_y) * scale));
+    keys[i].leaf = i;
+  }
+  qsort(keys, k, sizeof(LeafKey), compare_leaf_keys);
+  for(int i=0; i<k; i++) leaf_order[i] = keys[i].leaf;
+
+  if(k % 2 == 0 && k > 2 && pairing_cost(1) + node_distance(
+       leaf_candidate[leaf_order[k - 1]], leaf_candidate[leaf_order[0]]) < pairing_cost(0)) {
+    int first = leaf_order[0];
+    memmove(leaf_order, leaf_order + 1, sizeof(int) * (k - 1));
+    leaf_order[k - 1] = first;
+  }
+
+  for(int i=0; i+2<k; i+=2) {
+    if(leaf_cut[leaf_order[i]] == leaf_cut[leaf_order[i + 1]] &&
+       leaf_cut[leaf_order[i]] != leaf_cut[leaf_order[i + 2]]) {
+      int t = leaf_order[i + 1];
+      leaf_order[i + 1] = leaf_order[i + 2];
+      leaf_order[i + 2] = t;
+    }
+  }
+}
+
+/* Non-cut node of the block nearest to target (the leaf's own candidate
+ * if the block has no non-cut node) */
+static int nearest_non_cut_in_block(int block, int target, int fallback) {
+  int best = fallback;
+  double best_d = fallback >= 0 ? node_distance(fallback, target) : 0.0;
+  for(int i=0; i<block_size[block]; i++) {
+    int node = block_nodes[block][i];
+    if(is_cut[node]) continue;
+    double d = node_distance(node, target);
+    if(d < best_d || (d == best_d && node < best)) {
+      best = node;
+      best_d = d;
+    }
+  }
+  return best;
+}
+
+/* ----------------- Redundant edge insertion ------------------ */
+
+static int add_redundant_edge(int node1, int node2) {
+  if(node1 == -1 || node2 == -1 || node1 == node2 || exists_edge[node1][node2]) return 0;
+  if(degree[node1] >= MAX_NEIGHBORS || degree[node2] >= MAX_NEIGHBORS) return 0;
+
+  neighbors[node1][degree[node1]++] = node2;
+  neighbors[node2][degree[node2]++] = node1;
+  exists_edge[node1][node2] = exists_edge[node2][node1] = 1;
+  redundant_edge[node1][node2] = redundant_edge[node2][node1] = 1;
+  redundant_edges_added++;
+  added_link_length += node_distance(node1, node2);
+  added_link_energy += link_energy_cost(node1, degree[node1] - 1) +
+                       link_energy_cost(node2, degree[node2] - 1);
+  if(node_battery[node1] < min_endpoint_battery) min_endpoint_battery = node_battery[node1];
+  if(node_battery[node2] < min_endpoint_battery) min_endpoint_battery = node_battery[node2];
+  blocks_valid = 0;
+  return 1;
+}
+
+/* ----------------- Relay placement ------------------ */
+
+/* Uniform grid of radio-range cells, hashed into buckets, over node
+ * positions. Everything within range of a point lies in its 3x3 cells. */
+#define RELAY_GRID_BUCKETS 4096
+static int grid_head[RELAY_GRID_BUCKETS];
+static int grid_next[MAX_NODES];
+
+static inline unsigned int grid_bucket(double x, double y) {
+  int cx = (int)floor(x / RADIO_RANGE), cy = (int)floor(y / RADIO_RANGE);
+  return hash_u32((unsigned int)cx * 73856093U ^ (unsigned int)cy * 19349663U) %
+         RELAY_GRID_BUCKETS;
+}
+
+static void grid_insert(int node) {
+  unsigned int b = grid_bucket(node_x[node], node_y[node]);
+  grid_next[node] = grid_head[b];
+  grid_head[b] = node;
+}
+
+static void build_relay_grid(void) {
+  for(int b=0; b<RELAY_GRID_BUCKETS; b++) grid_head[b] = -1;
+  for(int i=0; i<n_nodes; i++) grid_insert(i);
+}
+
+/* Non-cut node within range of `from` that gets closest to `to`, if it
+ * gets at least a tenth of the range closer than `from` is. The hop
+ * becomes a path interior, so it needs two free neighbor slots. */
+static int best_hop_toward(int from, int to) {
+  int best = -1;
+  double best_d = node_distance(from, to) - 0.1 * RADIO_RANGE;
+
+  for(int dx=-1; dx<=1; dx++) {
+    for(int dy=-1; dy<=1; dy++) {
+      unsigned int b = grid_bucket(node_x[from] + dx * RADIO_RANGE,
+                                   node_y[from] + dy * RADIO_RANGE);
+      for(int c=grid_head[b]; c!=-1; c=grid_next[c]) {
+        if(c == from || is_cut[c] || exists_edge[from][c]) continue;
+        if(degree[c] > MAX_NEIGHBORS - 2) continue;
+        if(node_distance(from, c) > RADIO_RANGE) continue;
+        double d = node_distance(c, to);
+        if(d < best_d || (d == best_d && c < best)) {
+          best = c;
+          best_d = d;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+/* Joins a and b by a path of links no longer than the radio range.
+ * Each hop goes to an existing node in range that makes progress
+ * toward b (relays placed for earlier pairs included, so nearby pairs
+ * share them as Steiner points); a new relay is placed 0.95 ranges
+ * along the line only when there is none. A path with non-cut interior
+ * nodes closes the same cycle as a direct a-b link.
+ *
+ * The whole path is planned before anything is added, new relays in
+ * the free slots past n_nodes, so a pair that cannot be joined leaves
+ * the graph untouched instead of with a dangling chain. Returns the
+ * number of links added. */
+static int add_relay_path(int a, int b) {
+  static int path[MAX_NODES];
+  if(a == -1 || b == -1 || a == b || exists_edge[a][b]) return 0;
+  if(degree[a] >= MAX_NEIGHBORS || degree[b] >= MAX_NEIGHBORS) return 0;
+
+  int len = 0, fresh = n_nodes, p = a;
+  path[len++] = a;
+  while(node_distance(p, b) > RADIO_RANGE) {
+    int next = best_hop_toward(p, b);
+    if(next == -1) {
+      if(fresh >= MAX_NODES) {
+        LOG_WARN("No room for relay between %d and %d (MAX_NODES)\n", a, b);
+        return 0;
+      }
+      double d = node_distance(p, b);
+      next = fresh++;
+      node_x[next] = node_x[p] + (node_x[b] - node_x[p]) * 0.95 * RADIO_RANGE / d;
+      node_y[next] = node_y[p] + (node_y[b] - node_y[p]) * 0.95 * RADIO_RANGE / d;
+    }
+    path[len++] = next;
+    p = next;
+  }
+
+  /* Planned relays take their slots in path order */
+  for(int i=1; i<len; i++) {
+    int r = path[i];
+    if(r < n_nodes) continue;
+    n_nodes++;
+    degree[r] = 0;
+    is_cut[r] = 0;
+    is_relay[r] = 1;
+    node_battery[r] = 1.0;
+    relays_added++;
+    grid_insert(r);
+  }
+
+  int added = 0;
+  for(int i=1; i<len; i++) added += add_redundant_edge(path[i-1], path[i]);
+  /* The last hop may already neighbor b, which closes the cycle too */
+  if(!exists_edge[p][b]) added += add_redundant_edge(p, b);
+  return added;
+}
+
+/* Turns leaf_order into links 0-1, 2-3, ... without touching the
+ * graph. Returns the number of links; an endpoint is -1 when its leaf
+ * had no candidate. */
+int pair_leaves(Edge *links) {
+  int n = 0;
+  if(select_mode == SELECT_ENERGY) energy_reset();
+  for(int i=0; i<num_leaf_blocks; i+=2) {
+    int a = leaf_order[i];
+    int b;
+    if(i+1 < num_leaf_blocks) {
+      b = leaf_order[i+1];
+    } else {
+      /* Odd leaf out: its curve neighbour when spatial, else leaf 0 */
+      b = (pairing_mode == PAIR_SPATIAL && i > 0) ? leaf_order[i-1] : leaf_order[0];
+    }
+    
+    int node1 = leaf_candidate[a];
+    int node2 = leaf_candidate[b];
+    
+    if(select_mode == SELECT_ENERGY) {
+      /* Cheapest endpoints; position only orders the leaves */
+      node1 = energy_take(a);
+      node2 = energy_take(b);
+    } else if(pairing_mode == PAIR_SPATIAL && node1 != -1 && node2 != -1) {
+      /* Shortest endpoints within the two blocks */
+      node1 = nearest_non_cut_in_block(leaf_blocks[a], node2, node1);
+      node2 = nearest_non_cut_in_block(leaf_blocks[b], node1, node2);
+    }
+    
+    links[n].u = node1;
+    links[n].v = node2;
+    n++;
+  }
+  return n;
+}
+
+/* Leaf links for the current leaf blocks and candidates, paired by
+ * pairing_mode. The plan itself is canonical: each link runs from its
+ * lower to its higher endpoint and links are sorted, so links are added
+ * (and relays numbered) in the same order however the plan was drawn. */
+int plan_leaf_links(Edge *links) {
+  if(pairing_mode == PAIR_SPATIAL) {
+    plan_spatial_pairing();
+  } else {
+    for(int i=0; i<num_leaf_blocks; i++) leaf_order[i] = i;
+  }
+  int n = pair_leaves(links);
+  for(int i=0; i<n; i++) {
+    if(links[i].u > links[i].v) {
+      int t = links[i].u;
+      links[i].u = links[i].v;
+      links[i].v = t;
+    }
+  }
+  qsort(links, n, sizeof(Edge), compare_edges);
+  return n;
+}
+
+void add_optimal_redundant_edges(void) {
+  identify_leaf_blocks();
+  
+  LOG_INFO("Found %d leaf blocks (need %d edges)\n", 
+           num_leaf_blocks, (num_leaf_blocks + 1) / 2);
+  
+  select_leaf_candidates();
+  int nlinks = plan_leaf_links(leaf_links);
+  
+  if(augment_mode == AUGMENT_RELAY) build_relay_grid();
+  
+  int added = 0, paths = 0;
+  for(int i=0; i<nlinks; i++) {
+    if(augment_mode == AUGMENT_RELAY) {
+      int hops = add_relay_path(leaf_links[i].u, leaf_links[i].v);
+      added += hops;
+      paths += hops > 0;
+    } else {
+      added += add_redundant_edge(leaf_links[i].u, leaf_links[i].v);
+    }
+  }
+  
+  LOG_INFO("Added %d optimal redundant edges (%.1f m of links)\n", added, added_link_length);
+  if(augment_mode == AUGMENT_RELAY) {
+    LOG_INFO("Placed %d relay nodes on %d paths, %d nodes total\n",
+             relays_added, paths, n_nodes);
+  }
+}
+
+/* ----------------- Compute metrics ------------------ */
+
+static int metrics_degree_sum;
+
+/* compute_network_metrics() in pieces: begin, the nodes lo .. hi-1,
+ * then finish once every node is counted */
+void network_metrics_begin(void) {
+  /* Count cut vertices; initial_cut_vertices was taken before healing */
+  final_cut_vertices = 0;
+  metrics_degree_sum = 0;
+  max_degree_initial = 0;
+  max_degree_final = 0;
+}
+
+void network_metrics_rows(int lo, int hi) {
+  for(int i=lo; i<hi; i++) {
+    if(is_cut[i]) final_cut_vertices++;
+    metrics_degree_sum += degree[i];
+    if(degree[i] > max_degree_final) max_degree_final = degree[i];
+  }
+}
+
+void network_metrics_finish(void) {
+  avg_degree_final = (double)metrics_degree_sum / n_nodes;
+  
+  /* Initial avg degree is calculated from original_edges */
+  avg_degree_initial = (2.0 * original_edges) / n_nodes;
+}
+
+void compute_network_metrics(void) {
+  network_metrics_begin();
+  network_metrics_rows(0, n_nodes);
+  network_metrics_finish();
+}
+
+/* ----------------- Export ------------------ */
+
+/* Links are written lowest endpoint first and in ascending order, so the
+ * file does not depend on the order links were inserted in */
+static void write_dot_header(FILE *f) {
+  fprintf(f, "graph DODAG {\n");
+  fprintf(f, "  layout=sfdp; K=0.5; overlap=prism; splines=true;\n");
+  fprintf(f, "  node [shape=circle,width=0.3,fixedsize=true,fontsize=8];\n");
+}
+
+/* Row r < n_nodes styles node r; row n_nodes + u lists u's links */
+static void write_dot_row(FILE *f, int show_redundant, int r) {
+  if(r < n_nodes) {
+    int u = r;
+    if(u == 0) {
+      fprintf(f, "  %d [color=blue,style=filled,fillcolor=lightblue];\n", u);
+    } else if(is_relay[u]) {
+      if(show_redundant) {
+        fprintf(f, "  %d [shape=box,color=\"#00AA00\",style=filled,fillcolor=palegreen];\n", u);
+      }
+    } else if(is_cut[u]) {
+      fprintf(f, "  %d [color=red,style=filled,fillcolor=pink];\n", u);
+    }
+    return;
+  }
+  
+  int u = r - n_nodes;
+  int higher[MAX_NEIGHBORS], count = 0;
+  for(int i=0; i<degree[u]; i++) {
+    if(neighbors[u][i] > u) higher[count++] = neighbors[u][i];
+  }
+  qsort(higher, count, sizeof(int), compare_ints);
+  
+  for(int i=0; i<count; i++) {
+    int v = higher[i];
+    if(i > 0 && v == higher[i - 1]) continue;
+    if(show_redundant && redundant_edge[u][v]) {
+      fprintf(f, "  %d -- %d [color=\"#00AA00\",penwidth=2.0];\n", u, v);
+    } else {
+      fprintf(f, "  %d -- %d [color=black];\n", u, v);
+    }
+  }
+}
+
+void write_dot_graph(FILE *f, int show_redundant) {
+  write_dot_header(f);
+  for(int r=0; r<2*n_nodes; r++) write_dot_row(f, show_redundant, r);
+  fprintf(f, "}\n");
+}
+
+void export_dot_graph(const char *fname, int show_redundant) {
+  FILE *f = fopen(fname, "w");
+  if(!f) {
+    LOG_ERR("Failed to open %s\n", fname);
+    return;
+  }
+  write_dot_graph(f, show_redundant);
+  fclose(f);
+  LOG_INFO("Exported %s\n", fname);
+}
+
+/* Per node ETX rank and preferred parent in the shortest-path tree,
+ * before and after healing; -1 marks an unreached node or the root's
+ * missing parent */
+static void write_rpl_header(FILE *f) {
+  fprintf(f, "# node rank-before parent-before rank-after parent-after\n");
+}
+
+static void write_rpl_row(FILE *f, int v) {
+  fprintf(f, "%d %d %d %d %d\n", v, rank_initial[v], rpl_parent_initial[v],
+          rank_final[v], rpl_parent_final[v]);
+}
+
+void export_rpl_tree(const char *fname) {
+  FILE *f = fopen(fname, "w");
+  if(!f) {
+    LOG_ERR("Failed to open %s\n", fname);
+    return;
+  }
+  write_rpl_header(f);
+  for(int v=0; v<n_nodes; v++) write_rpl_row(f, v);
+  fclose(f);
+  LOG_INFO("Exported %s\n", fname);
+}
+
+/* Renders both dot files; the cooperative mode runs it in the
+ * background instead of waiting on it */
+#define RENDER_COMMAND "sfdp -Tpng dodag_old.dot -o dodag_old.png 2>/dev/null && " \
+                       "sfdp -Tpng dodag_final.dot -o dodag_final.png 2>/dev/null"
+
+static void report_images(int ok, double ms) {
+  if(ok) {
+    LOG_INFO("SUCCESS: Generated PNG files (%.2f ms)\n", ms);
+  } else {
+    LOG_INFO("Install Graphviz: sudo apt-get install graphviz\n");
+    LOG_INFO("Manual: sfdp -Tpng dodag_old.dot -o dodag_old.png\n");
+  }
+}
+
+void generate_images(void) {
+  LOG_INFO("Generating PNG images...\n");
+  
+  double start = get_time_ms();
+  int ret = system(RENDER_COMMAND);
+  report_images(ret == 0, get_time_ms() - start);
+}
+
+void print_statistics(void) {
+  time_t now;
   struct tm *timeinfo;
   char timestamp[100];
   
@@ -430,6 +4790,11 @@ void print_statistics(void) {
   printf("║ Total Edges (Final):        %6d                          ║\n", original_edges + redundant_edges_added);
   printf("║ Edge Overhead:              %6.2f%%                       ║\n", 
          100.0 * redundant_edges_added / (original_edges > 0 ? original_edges : 1));
+  printf("║ Added Link Length:        %8.1f m                      ║\n", added_link_length);
+  printf("║ Relay Nodes Added:          %6d                          ║\n", relays_added);
+  printf("║ Added Link Energy:        %8.1f                        ║\n", added_link_energy);
+  printf("║ Min Endpoint Battery:       %6.0f%%                       ║\n",
+         redundant_edges_added > 0 ? 100.0 * min_endpoint_battery : 0.0);
   printf("╠════════════════════════════════════════════════════════════╣\n");
   printf("║ DEGREE DISTRIBUTION                                        ║\n");
   printf("╠════════════════════════════════════════════════════════════╣\n");
@@ -470,13 +4835,1139 @@ void print_statistics(void) {
   printf("╠════════════════════════════════════════════════════════════╣\n");
   printf("║ • dodag_old.dot     (Original topology)                   ║\n");
   printf("║ • dodag_final.dot   (Meshified topology)                  ║\n");
+  printf("║ • dodag_rpl.txt     (ETX ranks and RPL parents)           ║\n");
   printf("║ • dodag_old.png     (Original visualization)              ║\n");
   printf("║ • dodag_final.png   (Meshified visualization)             ║\n");
   printf("╚════════════════════════════════════════════════════════════╝\n\n");
 }
 
+/* ----------------- Engine benchmark ------------------ */
+
+typedef struct {
+  double ms;
+  int cuts;
+} EngineRun;
+
+/* Best-of-reps timing of one engine; small graphs are repeated so each
+ * measurement covers a few million adjacency entries */
+static EngineRun time_engine(const CsrGraph *g, engine_t engine, char *cut) {
+  int reps = g->m > 0 ? (int)(4000000L / g->m) : 1;
+  if(reps < 1) reps = 1;
+  if(reps > 1000) reps = 1000;
+
+  EngineRun run = { 0.0, 0 };
+  double start = get_time_ms();
+  for(int r=0; r<reps; r++) {
+    if(engine == ENGINE_CHAIN) {
+      ChainResult res;
+      run.cuts = chain_cut_vertices(g, cut, &res);
+    } else {
+      run.cuts = csr_cut_vertices(g, cut, NULL);
+    }
+  }
+  run.ms = (get_time_ms() - start) / reps;
+  return run;
+}
+
+static void engine_bench_row(const char *name, const CsrGraph *g) {
+  char *cut = malloc(g->n);
+  if(!cut) return;
+  EngineRun tj = time_engine(g, ENGINE_TARJAN, cut);
+  EngineRun ch = time_engine(g, ENGINE_CHAIN, cut);
+
+  /* Per-node state: Tarjan disc/low/parent/cursor/stack, chain
+   * dfi/parent/order/cursor/stack plus a visited byte */
+  double tj_kb = 5.0 * sizeof(int) * g->n / 1024.0;
+  double ch_kb = (5.0 * sizeof(int) + 1) * g->n / 1024.0;
+
+  printf("%-12s %9d %9d | %9.3f %8.1f %9.1f | %9.3f %8.1f %9.1f | %s\n",
+         name, g->n, g->m / 2,
+         tj.ms, tj.ms > 0 ? g->m / 2 / (tj.ms * 1000.0) : 0.0, tj_kb,
+         ch.ms, ch.ms > 0 ? g->m / 2 / (ch.ms * 1000.0) : 0.0, ch_kb,
+         tj.cuts == ch.cuts ? "match" : "MISMATCH");
+  free(cut);
+}
+
+/* Compares the Tarjan lowpoint and chain decomposition engines on every
+ * topology family at the configured node count, then on n-node
+ * synthetic graphs with local and scattered ids. */
+void run_engine_benchmark(int n) {
+  printf("\n%-12s %9s %9s | %9s %8s %9s | %9s %8s %9s | %s\n",
+         "family", "nodes", "edges",
+         "tarjan ms", "Medge/s", "state KB",
+         "chain ms", "Medge/s", "state KB", "cuts");
+
+  topology_kind_t saved = topology_kind;
+  for(int k=0; k<TOPO_COUNT; k++) {
+    CsrGraph g;
+    topology_kind = (topology_kind_t)k;
+    init_arrays();
+    generate_topology();
+    csr_from_graph(&g);
+    engine_bench_row(topology_names[k], &g);
+  }
+  topology_kind = saved;
+
+  for(int scatter=0; scatter<=1 && n > 1; scatter++) {
+    size_t offs_bytes = sizeof(int) * ((size_t)n + 1);
+    int *offs = numa_alloc(offs_bytes);
+    int *cursor = malloc(offs_bytes);
+    int *tgts = NULL;
+    size_t tgt_bytes = 0;
+
+    synthetic_scatter = scatter;
+    if(offs && cursor) {
+      int m = csr_synthetic_offsets(n, offs);
+      tgt_bytes = sizeof(int) * (size_t)m;
+      tgts = numa_alloc(tgt_bytes);
+      if(tgts) {
+        memcpy(cursor, offs, offs_bytes);
+        csr_synthetic_targets(n, cursor, tgts);
+        CsrGraph g = { n, m, offs, tgts };
+        engine_bench_row(scatter ? "scattered" : "site-local", &g);
+      }
+    }
+    synthetic_scatter = 0;
+    if(!tgts) LOG_ERR("Out of memory for %d-node benchmark\n", n);
+
+    free(cursor);
+    numa_free(offs, offs_bytes);
+    numa_free(tgts, tgt_bytes);
+  }
+  printf("\n");
+}
+
+/* ----------------- Huge page benchmark ------------------ */
+
+/* Runs the CSR cut-vertex engine on an n-node synthetic graph with ids
+ * scattered, so adjacency traversal is random, once per huge-page mode.
+ * Reports Tarjan time, dTLB read misses and the huge-page backed size. */
+void run_tlb_benchmark(int n) {
+  hugepage_mode_t saved = hugepage_mode;
+  synthetic_scatter = 1;
+
+  LOG_INFO("Huge page benchmark: %d nodes, scattered ids\n", n);
+  printf("\n%-9s %10s %10s %14s %12s %6s\n",
+         "pages", "build ms", "tarjan ms", "dTLB misses", "huge MB", "cuts");
+
+  for(int mode=HUGE_OFF; mode<=HUGE_EXPLICIT; mode++) {
+    hugepage_mode = (hugepage_mode_t)mode;
+
+    size_t offs_bytes = sizeof(int) * ((size_t)n + 1);
+    int *offs = numa_alloc(offs_bytes);
+    int *cursor = malloc(offs_bytes);
+    char *cut = malloc(n);
+    if(!offs || !cursor || !cut) {
+      LOG_ERR("Out of memory for %d-node benchmark\n", n);
+      numa_free(offs, offs_bytes);
+      free(cursor);
+      free(cut);
+      break;
+    }
+
+    double start = get_time_ms();
+    int m = csr_synthetic_offsets(n, offs);
+    size_t tgt_bytes = sizeof(int) * (size_t)m;
+    int *tgts = numa_alloc(tgt_bytes);
+    if(!tgts) {
+      LOG_ERR("Out of memory for %d-node benchmark\n", n);
+      numa_free(offs, offs_bytes);
+      free(cursor);
+      free(cut);
+      break;
+    }
+    memcpy(cursor, offs, offs_bytes);
+    csr_synthetic_targets(n, cursor, tgts);
+    free(cursor);
+    double t_build = get_time_ms() - start;
+
+    CsrGraph g = { n, m, offs, tgts };
+    int fd = perf_counter_open(PERF_TYPE_HW_CACHE, DTLB_READ_MISS);
+    start = get_time_ms();
+    int cuts = csr_cut_vertices(&g, cut, NULL);
+    double t_tarjan = get_time_ms() - start;
+    long long misses = perf_counter_close(fd);
+    long huge_kb = anon_hugepages_kb();
+
+    char miss_buf[24];
+    if(misses >= 0) snprintf(miss_buf, sizeof(miss_buf), "%lld", misses);
+    else snprintf(miss_buf, sizeof(miss_buf), "n/a");
+
+    printf("%-9s %10.2f %10.2f %14s %12.1f %6d\n",
+           hugepage_names[mode], t_build, t_tarjan, miss_buf,
+           huge_kb >= 0 ? huge_kb / 1024.0 : 0.0, cuts);
+
+    numa_free(offs, offs_bytes);
+    numa_free(tgts, tgt_bytes);
+    free(cut);
+  }
+  printf("\n");
+
+  synthetic_scatter = 0;
+  hugepage_mode = saved;
+}
+
+/* ----------------- Prefetch benchmark ------------------ */
+
+#define CACHE_LLC_READ_MISS (PERF_COUNT_HW_CACHE_LL | \
+                             (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/* Runs the CSR DFS on an n-node scattered graph (far larger than L3 for
+ * n in the millions) at several prefetch distances. Reports time, LLC
+ * read misses and speedup over the plain walk. */
+void run_prefetch_benchmark(int n) {
+  static const int distances[] = { 0, 1, 2, 4, 8, 16 };
+  int saved = prefetch_distance;
+  synthetic_scatter = 1;
+
+  size_t offs_bytes = sizeof(int) * ((size_t)n + 1);
+  int *offs = numa_alloc(offs_bytes);
+  int *cursor = malloc(offs_bytes);
+  char *cut = malloc(n);
+  int *tgts = NULL;
+  size_t tgt_bytes = 0;
+
+  if(offs && cursor && cut) {
+    int m = csr_synthetic_offsets(n, offs);
+    tgt_bytes = sizeof(int) * (size_t)m;
+    tgts = numa_alloc(tgt_bytes);
+    if(tgts) {
+      memcpy(cursor, offs, offs_bytes);
+      csr_synthetic_targets(n, cursor, tgts);
+    }
+  }
+  free(cursor);
+  if(!tgts) {
+    LOG_ERR("Out of memory for %d-node benchmark\n", n);
+    numa_free(offs, offs_bytes);
+    free(cut);
+    synthetic_scatter = 0;
+    return;
+  }
+
+  CsrGraph g = { n, offs[n], offs, tgts };
+  LOG_INFO("Prefetch benchmark: %d nodes, %d edges, %.1f MB of DFS state\n",
+           n, g.m / 2, (5.0 * sizeof(int) * n + offs_bytes + tgt_bytes) / (1024.0 * 1024.0));
+  printf("\n%-9s %10s %14s %8s %6s\n", "distance", "tarjan ms", "LLC misses", "speedup", "cuts");
+
+  double base = 0.0;
+  for(size_t k=0; k<sizeof(distances) / sizeof(distances[0]); k++) {
+    prefetch_distance = distances[k];
+    int fd = perf_counter_open(PERF_TYPE_HW_CACHE, CACHE_LLC_READ_MISS);
+    double start = get_time_ms();
+    int cuts = csr_cut_vertices(&g, cut, NULL);
+    double elapsed = get_time_ms() - start;
+    long long misses = perf_counter_close(fd);
+    if(k == 0) base = elapsed;
+
+    char miss_buf[24];
+    if(misses >= 0) snprintf(miss_buf, sizeof(miss_buf), "%lld", misses);
+    else snprintf(miss_buf, sizeof(miss_buf), "n/a");
+
+    printf("%-9d %10.2f %14s %7.2fx %6d\n", prefetch_distance, elapsed, miss_buf,
+           elapsed > 0 ? base / elapsed : 0.0, cuts);
+  }
+  printf("\n");
+
+  numa_free(offs, offs_bytes);
+  numa_free(tgts, tgt_bytes);
+  free(cut);
+  synthetic_scatter = 0;
+  prefetch_distance = saved;
+}
+
+/* ----------------- Block extraction benchmark ------------------ */
+
+/* Order-independent fingerprint of the current block table */
+static unsigned int blocks_fingerprint(void) {
+  unsigned int fp = (unsigned int)num_blocks;
+  for(int b=0; b<num_blocks; b++) {
+    unsigned int h = 0;
+    for(int i=0; i<block_size[b]; i++) h += hash_u32((unsigned int)block_nodes[b][i] + 1);
+    fp = hash_u32(fp ^ h ^ ((unsigned int)block_size[b] << 20));
+  }
+  return fp;
+}
+
+/* Edge-stack vs vertex-stack extraction on meshes of rising density.
+ * Both must yield the same blocks, in the same order, and the same cut
+ * vertices; reported memory is the block stack high-water plus the call
+ * stack (the edge-stack DFS carries one MAX_NODES dedupe array/frame). */
+void run_blocks_benchmark(void) {
+  static const double densities[] = { 0.15, 0.5, 1.0, 2.0 };
+  extraction_t saved_ex = block_extraction;
+  double saved_prob = connection_prob;
+  topology_kind_t saved_kind = topology_kind;
+
+  printf("\n%-14s %6s %7s | %9s %9s %9s | %9s %9s %9s | %9s | %s\n",
+         "mesh", "nodes", "edges",
+         "edge ms", "bstack KB", "stack KB",
+         "vertex ms", "bstack KB", "stack KB", "cut ms", "blocks");
+
+  for(size_t d=0; d<=sizeof(densities) / sizeof(densities[0]); d++) {
+    char name[32];
+    if(d < sizeof(densities) / sizeof(densities[0])) {
+      topology_kind = TOPO_RANDOM;
+      connection_prob = densities[d];
+      snprintf(name, sizeof(name), "random p=%.2f", connection_prob);
+    } else {
+      topology_kind = TOPO_BIPARTITE;
+      snprintf(name, sizeof(name), "bipartite");
+    }
+    init_arrays();
+    generate_topology();
+
+    double ms[2];
+    long bstack[2], cstack[2];
+    unsigned int fp[2], cuts[2];
+    for(int ex=0; ex<2; ex++) {
+      block_extraction = (extraction_t)ex;
+      int reps = 200;
+      double start = get_time_ms();
+      for(int r=0; r<reps; r++) find_biconnected_components();
+      ms[ex] = (get_time_ms() - start) / reps;
+      bstack[ex] = block_stack_bytes();
+      cstack[ex] = (dfs_stack_base && dfs_stack_deepest) ?
+                   (long)(dfs_stack_base - dfs_stack_deepest) : 0;
+      fp[ex] = blocks_fingerprint();
+      cuts[ex] = 0;
+      for(int i=0; i<n_nodes; i++) cuts[ex] = cuts[ex] * 31U + (unsigned int)is_cut[i];
+    }
+
+    /* Cut-vertex-only pass, as used for verification */
+    int blocks = num_blocks;
+    double start = get_time_ms();
+    for(int r=0; r<200; r++) find_cut_vertices();
+    double cut_ms = (get_time_ms() - start) / 200;
+    unsigned int cut_only = 0;
+    for(int i=0; i<n_nodes; i++) cut_only = cut_only * 31U + (unsigned int)is_cut[i];
+
+    printf("%-14s %6d %7d | %9.3f %9.1f %9.1f | %9.3f %9.1f %9.1f | %9.3f | %d %s\n",
+           name, n_nodes, original_edges,
+           ms[0], bstack[0] / 1024.0, cstack[0] / 1024.0,
+           ms[1], bstack[1] / 1024.0, cstack[1] / 1024.0, cut_ms,
+           blocks, (fp[0] == fp[1] && cuts[0] == cuts[1] && cuts[0] == cut_only &&
+                    blocks == num_blocks) ? "identical" : "DIFFER");
+  }
+  printf("\n");
+
+  block_extraction = saved_ex;
+  connection_prob = saved_prob;
+  topology_kind = saved_kind;
+}
+
+/* ----------------- What-if benchmark ------------------ */
+
+#define WHATIF_LARGE_LINKS 64
+
+/* Same comparison on an n-node synthetic graph with plans sets of
+ * random links, where rebuilding means copying the whole adjacency */
+static void run_whatif_large(int plans, int n) {
+  static Edge links[WHATIF_LARGE_LINKS];
+  size_t offs_bytes = sizeof(int) * ((size_t)n + 1);
+  int *offs = numa_alloc(offs_bytes);
+  int *merged_offs = numa_alloc(offs_bytes);
+  int *cursor = malloc(offs_bytes);
+  char *cut = malloc(n);
+  int *tgts = NULL, *merged_tgts = NULL;
+  size_t tgt_bytes = 0, merged_bytes = 0;
+
+  if(offs && merged_offs && cursor && cut) {
+    int m = csr_synthetic_offsets(n, offs);
+    tgt_bytes = sizeof(int) * (size_t)m;
+    merged_bytes = sizeof(int) * ((size_t)m + 2 * WHATIF_LARGE_LINKS);
+    tgts = numa_alloc(tgt_bytes);
+    merged_tgts = numa_alloc(merged_bytes);
+  }
+  if(!tgts || !merged_tgts) {
+    LOG_ERR("Out of memory for %d-node what-if benchmark\n", n);
+    goto out;
+  }
+
+  memcpy(cursor, offs, offs_bytes);
+  csr_synthetic_targets(n, cursor, tgts);
+  CsrGraph base = { n, offs[n], offs, tgts };
+
+  printf("Synthetic %d nodes, %d edges, %d links per plan\n", n, base.m / 2, WHATIF_LARGE_LINKS);
+  double overlay_total = 0.0, rebuild_total = 0.0;
+  for(int p=0; p<plans; p++) {
+    for(int i=0; i<WHATIF_LARGE_LINKS; i++) {
+      links[i].u = hash_u32((unsigned int)(p * 131 + 2 * i)) % (unsigned int)n;
+      links[i].v = hash_u32((unsigned int)(p * 131 + 2 * i + 1)) % (unsigned int)n;
+    }
+
+    double start = get_time_ms();
+    OverlayGraph o;
+    if(overlay_build(&o, &base, links, WHATIF_LARGE_LINKS) != 0) {
+      LOG_ERR("Out of memory for plan %d overlay\n", p);
+      overlay_free(&o);
+      goto out;
+    }
+    int cuts = overlay_cut_vertices(&o, cut);
+    overlay_total += get_time_ms() - start;
+
+    start = get_time_ms();
+    int pos = overlay_flatten(&o, merged_offs, merged_tgts);
+    CsrGraph merged = { n, pos, merged_offs, merged_tgts };
+    int check = csr_cut_vertices(&merged, cut, NULL);
+    rebuild_total += get_time_ms() - start;
+    overlay_free(&o);
+
+    if(check != cuts) LOG_ERR("Plan %d: overlay %d vs rebuilt %d cut vertices\n", p, cuts, check);
+  }
+
+  printf("Average per plan: overlay %.3f ms, rebuild %.3f ms; "
+         "extra memory %zu bytes vs %zu bytes\n\n",
+         overlay_total / plans, rebuild_total / plans,
+         sizeof(Edge) * 2 * WHATIF_LARGE_LINKS, offs_bytes + merged_bytes);
+
+out:
+  numa_free(offs, offs_bytes);
+  numa_free(merged_offs, offs_bytes);
+  numa_free(tgts, tgt_bytes);
+  numa_free(merged_tgts, merged_bytes);
+  free(cursor);
+  free(cut);
+}
+
+/* Evaluates plans candidate link sets on the generated topology: the
+ * sequential and spatial pairings, then shuffled pairings. Each plan is
+ * analysed once on an overlay of the shared base CSR and once on a CSR
+ * rebuilt with the links merged in, to show what the overlay saves. The
+ * graph itself is never modified. With n > 1 the comparison is repeated
+ * on an n-node synthetic graph. */
+void run_whatif_benchmark(int plans, int n) {
+  static int merged_offsets[MAX_NODES + 1];
+  static int merged_targets[MAX_NODES * MAX_NEIGHBORS + MAX_BLOCKS + 2];
+  static char cut[MAX_NODES];
+  pairing_t saved_pairing = pairing_mode;
+
+  init_arrays();
+  generate_topology();
+  find_biconnected_components();
+  identify_leaf_blocks();
+  select_leaf_candidates();
+
+  CsrGraph base;
+  csr_from_graph(&base);
+
+  int initial = 0;
+  for(int i=0; i<n_nodes; i++) if(is_cut[i]) initial++;
+  printf("\nWhat-if: %d nodes, %d edges, %d cut vertices, %d leaf blocks, %d plans\n",
+         n_nodes, original_edges, initial, num_leaf_blocks, plans);
+  printf("%-12s %6s %10s %6s | %11s %11s\n",
+         "plan", "links", "length m", "cuts", "overlay ms", "rebuild ms");
+
+  double overlay_total = 0.0, rebuild_total = 0.0;
+  int best = -1, best_cuts = 0;
+  double best_len = 0.0;
+
+  for(int p=0; p<plans; p++) {
+    if(p < 2) {
+      pairing_mode = p == 0 ? PAIR_SEQUENTIAL : PAIR_SPATIAL;
+      plan_leaf_links(leaf_links);
+    } else {
+      pairing_mode = PAIR_SEQUENTIAL;
+      for(int i=0; i<num_leaf_blocks; i++) leaf_order[i] = i;
+      for(int i=num_leaf_blocks-1; i>0; i--) {
+        int j = hash_u32((unsigned int)(p * 7919 + i)) % (unsigned int)(i + 1);
+        int t = leaf_order[i]; leaf_order[i] = leaf_order[j]; leaf_order[j] = t;
+      }
+    }
+    int nlinks = pair_leaves(leaf_links);
+
+    double len = 0.0;
+    for(int i=0; i<nlinks; i++) {
+      if(leaf_links[i].u >= 0 && leaf_links[i].v >= 0) {
+        len += node_distance(leaf_links[i].u, leaf_links[i].v);
+      }
+    }
+
+    double start = get_time_ms();
+    OverlayGraph o;
+    if(overlay_build(&o, &base, leaf_links, nlinks) != 0) {
+      LOG_ERR("Out of memory for plan %d overlay\n", p);
+      overlay_free(&o);
+      plans = p;
+      break;
+    }
+    int cuts = overlay_cut_vertices(&o, cut);
+    double t_overlay = get_time_ms() - start;
+
+    /* Same analysis on a rebuilt CSR */
+    start = get_time_ms();
+    int pos = overlay_flatten(&o, merged_offsets, merged_targets);
+    CsrGraph merged = { base.n, pos, merged_offsets, merged_targets };
+    int check = csr_cut_vertices(&merged, cut, NULL);
+    double t_rebuild = get_time_ms() - start;
+    overlay_free(&o);
+
+    overlay_total += t_overlay;
+    rebuild_total += t_rebuild;
+    if(check != cuts) LOG_ERR("Plan %d: overlay %d vs rebuilt %d cut vertices\n", p, cuts, check);
+
+    if(best < 0 || cuts < best_cuts || (cuts == best_cuts && len < best_len)) {
+      best = p;
+      best_cuts = cuts;
+      best_len = len;
+    }
+
+    if(p < 10 || p == plans - 1) {
+      char name[24];
+      if(p < 2) snprintf(name, sizeof(name), "%s", pairing_names[p]);
+      else snprintf(name, sizeof(name), "shuffle %d", p - 1);
+      printf("%-12s %6d %10.1f %6d | %11.3f %11.3f\n",
+             name, nlinks, len, cuts, t_overlay, t_rebuild);
+    }
+  }
+
+  if(plans > 0) {
+    printf("\nBest plan: #%d, %d cut vertices, %.1f m of links\n", best, best_cuts, best_len);
+    printf("Average per plan: overlay %.3f ms, rebuild %.3f ms\n\n",
+           overlay_total / plans, rebuild_total / plans);
+  }
+
+  pairing_mode = saved_pairing;
+  if(n > 1) run_whatif_large(plans, n);
+}
+
+/* ----------------- Version benchmark ------------------ */
+
+#define VERSION_BENCH_MS 1000.0
+#define VERSION_BATCH_LINKS 32
+#define VERSION_QUERY_BURST 256
+
+typedef struct {
+  int n;
+  int writing;
+  int stop;
+  long published;
+  double publish_ms;
+  long queries[MAX_CPUS];
+} VersionBench;
+
+/* Thread 0 is the writer: it publishes a version per batch of random
+ * links while writing is set, otherwise it only keeps time. The other
+ * threads query cut status and degree of random nodes, holding one
+ * version per burst of queries. */
+static void version_bench_worker(int tid, int nthreads, void *arg) {
+  VersionBench *b = arg;
+  static Edge batch[VERSION_BATCH_LINKS];
+
+  if(tid == 0) {
+    double start = get_time_ms();
+    while(get_time_ms() - start < VERSION_BENCH_MS) {
+      if(!b->writing) {
+        usleep(1000);
+        continue;
+      }
+      GraphVersion *cur = gv_current;
+      for(int i=0; i<VERSION_BATCH_LINKS; i++) {
+        unsigned int h = (unsigned int)(cur->id * VERSION_BATCH_LINKS + i);
+        batch[i].u = hash_u32(2 * h) % (unsigned int)b->n;
+        batch[i].v = hash_u32(2 * h + 1) % (unsigned int)b->n;
+      }
+      double t = get_time_ms();
+      GraphVersion *next = version_next(cur, batch, VERSION_BATCH_LINKS);
+      if(!next) break;
+      version_publish(next, nthreads);
+      b->publish_ms += get_time_ms() - t;
+      b->published++;
+    }
+    __atomic_store_n(&b->stop, 1, __ATOMIC_RELEASE);
+    return;
+  }
+
+  unsigned int seed = hash_u32((unsigned int)tid);
+  long queries = 0, sum = 0;
+  while(!__atomic_load_n(&b->stop, __ATOMIC_ACQUIRE)) {
+    const GraphVersion *v = version_enter(tid);
+    for(int q=0; q<VERSION_QUERY_BURST; q++) {
+      seed = hash_u32(seed);
+      int u = seed % (unsigned int)b->n;
+      sum += v->cut[u] + version_degree(v, u);
+    }
+    version_exit(tid);
+    queries += VERSION_QUERY_BURST;
+  }
+  b->queries[tid] = queries + (sum == -1);
+}
+
+/* Query throughput on an n-node synthetic graph with num_threads - 1
+ * readers, first with an idle writer and then with the writer
+ * publishing a new version per batch */
+void run_version_benchmark(int n) {
+  int nthreads = num_threads < 2 ? 2 : num_threads;
+  size_t offs_bytes = sizeof(int) * ((size_t)n + 1);
+  int *offs = numa_alloc(offs_bytes);
+  int *cursor = malloc(offs_bytes);
+  int *tgts = NULL;
+  size_t tgt_bytes = 0;
+
+  if(offs && cursor) {
+    int m = csr_synthetic_offsets(n, offs);
+    tgt_bytes = sizeof(int) * (size_t)m;
+    tgts = numa_alloc(tgt_bytes);
+  }
+  if(!tgts) {
+    LOG_ERR("Out of memory for %d-node version benchmark\n", n);
+    free(cursor);
+    numa_free(offs, offs_bytes);
+    return;
+  }
+  memcpy(cursor, offs, offs_bytes);
+  csr_synthetic_targets(n, cursor, tgts);
+  free(cursor);
+
+  CsrGraph g = { n, offs[n], offs, tgts };
+  GraphVersion *first = version_create(&g, offs_bytes, tgt_bytes);
+  if(!first) {
+    LOG_ERR("Out of memory for %d-node version benchmark\n", n);
+    numa_free(offs, offs_bytes);
+    numa_free(tgts, tgt_bytes);
+    return;
+  }
+  version_publish(first, 0);
+
+  printf("\nVersioned graph: %d nodes, %d edges, %d readers, %.0f ms per phase\n",
+         n, g.m / 2, nthreads - 1, VERSION_BENCH_MS);
+  printf("%-12s %10s %9s %9s %8s %11s %6s\n",
+         "phase", "Mquery/s", "versions", "reclaimed", "pending", "publish ms", "cuts");
+
+  for(int writing=0; writing<=1; writing++) {
+    static VersionBench b;
+    memset(&b, 0, sizeof(b));
+    b.n = n;
+    b.writing = writing;
+    long reclaimed0 = gv_reclaimed;
+    gv_pending_peak = gv_pending;
+
+    double start = get_time_ms();
+    int team = run_parallel(nthreads, version_bench_worker, &b);
+    double ms = get_time_ms() - start;
+
+    /* Thread 0 writes; readers are the rest of the team actually started */
+    long queries = 0;
+    for(int t=1; t<team; t++) queries += b.queries[t];
+    if(team < nthreads) printf("(%d of %d readers started)\n", team - 1, nthreads - 1);
+    printf("%-12s %10.2f %9ld %9ld %8d %11.3f %6d\n",
+           writing ? "read+write" : "read-only", queries / ms / 1000.0,
+           b.published, gv_reclaimed - reclaimed0, gv_pending_peak,
+           b.published ? b.publish_ms / b.published : 0.0, gv_current->cut_count);
+  }
+  printf("\n");
+
+  version_shutdown();
+}
+
+/* ----------------- Query benchmark ------------------ */
+
+#define QUERY_BENCH_MS 500.0
+
+typedef struct {
+  int readers;
+  int stop;
+  long publications;
+  long queries[MAX_CPUS];
+  long retries[MAX_CPUS];
+} QueryBench;
+
+/* Thread 0 re-analyses the graph and publishes continuously; threads
+ * 1 .. readers query random nodes until it stops */
+static void query_bench_worker(int tid, int nthreads, void *arg) {
+  QueryBench *q = arg;
+  (void)nthreads;
+
+  if(tid == 0) {
+    double start = get_time_ms();
+    while(get_time_ms() - start < QUERY_BENCH_MS) {
+      blocks_valid = 0;
+      result_publish(1);
+      q->publications++;
+    }
+    __atomic_store_n(&q->stop, 1, __ATOMIC_RELEASE);
+    return;
+  }
+
+  unsigned int seed = hash_u32((unsigned int)tid);
+  long queries = 0, retries = 0, sum = 0;
+  while(!__atomic_load_n(&q->stop, __ATOMIC_ACQUIRE)) {
+    for(int i=0; i<256; i++) {
+      int blk;
+      seed = hash_u32(seed);
+      sum += result_query((int)(seed % (unsigned int)n_nodes), &blk, &retries) + blk;
+    }
+    queries += 256;
+  }
+  q->queries[tid] = queries + (sum == -1);
+  q->retries[tid] = retries;
+}
+
+/* Query throughput against a continuously republished result set, for
+ * 1, 2, 4 ... num_threads readers */
+void run_query_benchmark(void) {
+  init_arrays();
+  generate_topology();
+  find_biconnected_components();
+  result_publish(1);
+
+  printf("\nResult set: %d nodes, %d blocks, %.0f ms per row\n",
+         n_nodes, num_blocks, QUERY_BENCH_MS);
+  printf("%7s %10s %12s %10s %12s\n",
+         "readers", "Mquery/s", "per reader", "retries", "publications");
+
+  for(int readers=1; readers<=num_threads; readers*=2) {
+    static QueryBench q;
+    memset(&q, 0, sizeof(q));
+    q.readers = readers;
+
+    double start = get_time_ms();
+    int team = run_parallel(readers + 1, query_bench_worker, &q);
+    double ms = get_time_ms() - start;
+
+    /* Thread 0 publishes; readers are the rest of the team actually started */
+    int started = team - 1;
+    long queries = 0, retries = 0;
+    for(int t=1; t<team; t++) {
+      queries += q.queries[t];
+      retries += q.retries[t];
+    }
+    printf("%7d %10.2f %12.2f %10ld %12ld\n", started, queries / ms / 1000.0,
+           started > 0 ? queries / ms / 1000.0 / started : 0.0, retries, q.publications);
+  }
+  printf("\n");
+}
+
+/* ----------------- Shortest path benchmark ------------------ */
+
+/* Binary-heap Dijkstra with lazy deletion, the reference for sssp_dial */
+static int sssp_binary_heap(const CsrGraph *g, const unsigned short *w, int src,
+                            int *dist, int *parent) {
+  typedef struct { int d, v; } HeapEntry;
+  size_t cap = (size_t)g->m + 1;
+  HeapEntry *h = malloc(sizeof(HeapEntry) * cap);
+  int len = 0, reached = 0;
+  if(!h) return -1;
+
+  for(int i=0; i<g->n; i++) {
+    dist[i] = SSSP_UNREACHED;
+    parent[i] = -1;
+  }
+  dist[src] = 0;
+  h[len++] = (HeapEntry){ 0, src };
+
+  while(len > 0) {
+    HeapEntry top = h[0], last = h[--len];
+    int i = 0;
+    for(;;) {
+      int c = 2 * i + 1;
+      if(c >= len) break;
+      if(c + 1 < len && h[c + 1].d < h[c].d) c++;
+      if(h[c].d >= last.d) break;
+      h[i] = h[c];
+      i = c;
+    }
+    if(len > 0) h[i] = last;
+    if(top.d != dist[top.v]) continue;
+    reached++;
+
+    int u = top.v;
+    for(int c=g->offsets[u]; c<g->offsets[u + 1]; c++) {
+      int v = g->targets[c];
+      int nd = dist[u] + w[c];
+      if(nd < dist[v]) {
+        dist[v] = nd;
+        parent[v] = u;
+        int k = len++;
+        while(k > 0 && h[(k - 1) / 2].d > nd) {
+          h[k] = h[(k - 1) / 2];
+          k = (k - 1) / 2;
+        }
+        h[k] = (HeapEntry){ nd, v };
+      } else if(nd == dist[v] && u < parent[v]) {
+        parent[v] = u;
+      }
+    }
+  }
+
+  free(h);
+  return reached;
+}
+
+/* ETX shortest-path tree from node 0 on n-node synthetic graphs, site
+ * local and scattered, Dial buckets against a binary heap */
+void run_sssp_benchmark(int n) {
+  printf("\n%-12s %9s %9s | %9s %8s | %9s %8s | %7s %9s %8s %s\n",
+         "graph", "nodes", "edges", "dial ms", "Medge/s", "heap ms", "Medge/s",
+         "speedup", "reached", "max rank", "tree");
+
+  for(int scatter=0; scatter<=1; scatter++) {
+    size_t offs_bytes = sizeof(int) * ((size_t)n + 1);
+    size_t node_bytes = sizeof(int) * (size_t)n;
+    int *offs = numa_alloc(offs_bytes);
+    int *cursor = malloc(offs_bytes);
+    int *dist[2] = { numa_alloc(node_bytes), numa_alloc(node_bytes) };
+    int *parent[2] = { numa_alloc(node_bytes), numa_alloc(node_bytes) };
+    int *tgts = NULL;
+    unsigned short *w = NULL;
+    size_t tgt_bytes = 0, w_bytes = 0;
+
+    synthetic_scatter = scatter;
+    if(offs && cursor && dist[0] && dist[1] && parent[0] && parent[1]) {
+      int m = csr_synthetic_offsets(n, offs);
+      tgt_bytes = sizeof(int) * (size_t)m;
+      w_bytes = sizeof(unsigned short) * (size_t)m;
+      tgts = numa_alloc(tgt_bytes);
+      w = numa_alloc(w_bytes);
+    }
+    if(tgts && w) {
+      memcpy(cursor, offs, offs_bytes);
+      csr_synthetic_targets(n, cursor, tgts);
+      CsrGraph g = { n, offs[n], offs, tgts };
+      etx_weights_synthetic(&g, w);
+
+      double start = get_time_ms();
+      int reached = sssp_dial(&g, w, 0, dist[0], parent[0]);
+      double dial_ms = get_time_ms() - start;
+
+      start = get_time_ms();
+      sssp_binary_heap(&g, w, 0, dist[1], parent[1]);
+      double heap_ms = get_time_ms() - start;
+
+      int max_rank = 0, same = 1;
+      for(int i=0; i<n; i++) {
+        if(dist[0][i] != dist[1][i] || parent[0][i] != parent[1][i]) same = 0;
+        if(dist[0][i] != SSSP_UNREACHED && RPL_ROOT_RANK + dist[0][i] > max_rank) {
+          max_rank = RPL_ROOT_RANK + dist[0][i];
+        }
+      }
+
+      printf("%-12s %9d %9d | %9.3f %8.1f | %9.3f %8.1f | %6.2fx %9d %8d %s\n",
+             scatter ? "scattered" : "site-local", n, g.m / 2,
+             dial_ms, dial_ms > 0 ? g.m / 2 / (dial_ms * 1000.0) : 0.0,
+             heap_ms, heap_ms > 0 ? g.m / 2 / (heap_ms * 1000.0) : 0.0,
+             dial_ms > 0 ? heap_ms / dial_ms : 0.0, reached, max_rank,
+             same ? "identical" : "DIFFER");
+    } else {
+      LOG_ERR("Out of memory for %d-node benchmark\n", n);
+    }
+    synthetic_scatter = 0;
+
+    free(cursor);
+    numa_free(offs, offs_bytes);
+    numa_free(tgts, tgt_bytes);
+    numa_free(w, w_bytes);
+    for(int k=0; k<2; k++) {
+      numa_free(dist[k], node_bytes);
+      numa_free(parent[k], node_bytes);
+    }
+  }
+  printf("\n");
+}
+
+/* ----------------- Hierarchical benchmark ------------------ */
+
+/* Two windmills of triangles, one per partition, with every node also
+ * linked to its twin: all nodes are kept and every triangle gets a hub,
+ * so the reduced graph has more nodes than the input */
+static void hier_windmill_check(int n) {
+  int h = (n / 2) | 1;
+  if(h < 3) h = 3;
+  int nodes = 2 * h;
+  long edges = 3L * (h - 1) + h;
+  size_t offs_bytes = sizeof(int) * ((size_t)nodes + 1);
+  size_t tgt_bytes = sizeof(int) * (size_t)(2 * edges);
+  size_t node_bytes = sizeof(int) * (size_t)nodes;
+  int *offs = numa_alloc(offs_bytes);
+  int *cursor = numa_alloc(offs_bytes);
+  int *tgts = numa_alloc(tgt_bytes);
+  int *part = numa_alloc(node_bytes);
+  char *flat = malloc(nodes);
+  char *cut = malloc(nodes);
+
+  if(offs && cursor && tgts && part && flat && cut) {
+    /* Node v of windmill s is s*h + v, centre v = 0; triangles (0, i, i+1)
+     * for odd i. Degrees first, then the same walk fills targets. */
+    for(int pass=0; pass<2; pass++) {
+      int *at = pass ? cursor : offs + 1;
+#define WM_LINK(a, b) do { \
+        if(pass) { tgts[at[a]++] = (b); tgts[at[b]++] = (a); } \
+        else { at[a]++; at[b]++; } \
+      } while(0)
+      for(int s=0; s<2; s++) {
+        int o = s * h;
+        for(int i=1; i<h; i+=2) {
+          WM_LINK(o, o + i);
+          WM_LINK(o, o + i + 1);
+          WM_LINK(o + i, o + i + 1);
+        }
+      }
+      for(int v=0; v<h; v++) WM_LINK(v, h + v);
+#undef WM_LINK
+      if(!pass) {
+        for(int v=0; v<nodes; v++) offs[v + 1] += offs[v];
+        memcpy(cursor, offs, offs_bytes);
+      }
+    }
+    for(int v=0; v<nodes; v++) part[v] = v >= h;
+
+    CsrGraph g = { nodes, offs[nodes], offs, tgts };
+    HierStats st;
+    int flat_cuts = csr_cut_vertices(&g, flat, NULL);
+    int cuts = hier_cut_vertices(&g, part, 2, cut, &st);
+    printf("%-11s %9d %6d %-5s | kept %d + hubs %d = %d reduced nodes | %d cuts %s\n",
+           "twin-wind", nodes, 2, "ids", st.kept, st.hubs, st.kept + st.hubs, cuts,
+           cuts == flat_cuts && memcmp(cut, flat, nodes) == 0 ? "exact" : "MISMATCH");
+  } else {
+    LOG_ERR("Out of memory for %d-node windmill check\n", nodes);
+  }
+
+  free(flat);
+  free(cut);
+  numa_free(offs, offs_bytes);
+  numa_free(cursor, offs_bytes);
+  numa_free(tgts, tgt_bytes);
+  numa_free(part, node_bytes);
+}
+
+/* Flat Tarjan against the partitioned analysis on n-node synthetic
+ * graphs, partitioned by id range and by label propagation. Id ranges
+ * follow the sites of the site-local graph and cut straight across the
+ * scattered one. Partitioning time counts towards the total. */
+void run_hier_benchmark(int n) {
+  int nparts = hier_parts > 0 ? hier_parts : (n + HIER_PART_NODES - 1) / HIER_PART_NODES;
+  if(nparts > n) nparts = n;
+
+  printf("\n%-11s %9s %6s %-5s | %8s %6s %5s %6s | %8s %7s %9s | %8s %8s %8s %8s | %8s %7s %s\n",
+         "graph", "nodes", "parts", "", "part ms", "cut %", "imbal", "1T",
+         "kept", "hubs", "reduced", "local ms", "reduce", "global", "total",
+         "flat ms", "speedup", "cuts");
+
+  for(int scatter=0; scatter<=1; scatter++) {
+    size_t offs_bytes = sizeof(int) * ((size_t)n + 1);
+    size_t node_bytes = sizeof(int) * (size_t)n;
+    int *offs = numa_alloc(offs_bytes);
+    int *cursor = numa_alloc(offs_bytes);
+    int *part = numa_alloc(node_bytes);
+    char *flat = malloc(n);
+    char *cut = malloc(n);
+    int *tgts = NULL;
+    size_t tgt_bytes = 0;
+
+    synthetic_scatter = scatter;
+    if(offs && cursor && part && flat && cut) {
+      tgt_bytes = sizeof(int) * (size_t)csr_synthetic_offsets(n, offs);
+      tgts = numa_alloc(tgt_bytes);
+    }
+    if(tgts) {
+      memcpy(cursor, offs, offs_bytes);
+      csr_synthetic_targets(n, cursor, tgts);
+      CsrGraph g = { n, offs[n], offs, tgts };
+
+      double start = get_time_ms();
+      int flat_cuts = csr_cut_vertices(&g, flat, NULL);
+      double flat_ms = get_time_ms() - start;
+
+      for(int method=0; method<2; method++) {
+        PartStats ps;
+        HierStats st;
+        if(partition_graph(&g, (partitioner_t)method, nparts, part, &ps) < 0) break;
+
+        /* The partition must not depend on the thread count */
+        const char *stable = "-";
+        if(method == PARTITION_LABEL_PROP && num_threads > 1) {
+          PartStats ps1;
+          int tuned = autotune;
+          autotune = 0;
+          memcpy(cursor, part, node_bytes);
+          label_propagation_partition(&g, nparts, cursor, 1, &ps1);
+          autotune = tuned;
+          stable = memcmp(cursor, part, node_bytes) == 0 ? "same" : "DIFFER";
+        }
+
+        int cuts = hier_cut_vertices(&g, part, nparts, cut, &st);
+        double total = ps.ms + st.local_ms + st.reduce_ms + st.global_ms;
+
+        printf("%-11s %9d %6d %-5s | %8.1f %6.2f %5.2f %6s | %8d %7d %9d | %8.1f %8.1f %8.1f %8.1f | %8.1f %6.2fx %d %s\n",
+               scatter ? "scattered" : "site-local", n, nparts, partitioner_names[method],
+               ps.ms, 100.0 * ps.cut_fraction, ps.imbalance, stable,
+               st.kept, st.hubs, st.reduced_m / 2,
+               st.local_ms, st.reduce_ms, st.global_ms, total,
+               flat_ms, total > 0 ? flat_ms / total : 0.0, cuts,
+               cuts == flat_cuts && memcmp(cut, flat, n) == 0 ? "exact" : "MISMATCH");
+      }
+    } else {
+      LOG_ERR("Out of memory for %d-node benchmark\n", n);
+    }
+    synthetic_scatter = 0;
+
+    free(flat);
+    free(cut);
+    numa_free(offs, offs_bytes);
+    numa_free(cursor, offs_bytes);
+    numa_free(part, node_bytes);
+    numa_free(tgts, tgt_bytes);
+  }
+  hier_windmill_check(n);
+  printf("(%d threads)\n\n", num_threads);
+  print_autotune_report();
+}
+
+/* Hierarchical mode for a CSR graph file (--external=FILE --hier):
+ * label-propagation partitions, --parts=K or one per HIER_PART_NODES,
+ * then hier_cut_vertices(). The whole file is mapped and read as
+ * needed; --mem-budget does not apply. Returns the cut vertex count,
+ * or -1. */
+int run_external_hier(const char *fname) {
+  CsrFileHeader h;
+  size_t length;
+  char *base = csr_map_file(fname, &h, &length);
+  if(!base) return -1;
+
+  const int *offs = (const int *)(base + sizeof(h));
+  CsrGraph g = { h.n, h.m, offs, offs + h.n + 1 };
+  int n = h.n;
+  int nparts = hier_parts > 0 ? hier_parts : (n + HIER_PART_NODES - 1) / HIER_PART_NODES;
+  if(nparts > n) nparts = n;
+
+  size_t node_bytes = sizeof(int) * (size_t)n;
+  int *part = numa_alloc(node_bytes);
+  char *cut = malloc(n);
+  int count = -1;
+  PartStats ps;
+  HierStats st;
+
+  LOG_INFO("Hierarchical analysis of %s: %d nodes, %d edges, %d partitions, %d threads\n",
+           fname, n, h.m / 2, nparts, num_threads);
+  if(!part || !cut) {
+    LOG_ERR("Out of memory for %d-node hierarchical analysis\n", n);
+  } else if(partition_graph(&g, PARTITION_LABEL_PROP, nparts, part, &ps) == 0) {
+    count = hier_cut_vertices(&g, part, nparts, cut, &st);
+  }
+
+  if(count >= 0) {
+    LOG_INFO("Hierarchical: %d cut vertices in %.2f ms\n", count,
+             ps.ms + st.local_ms + st.reduce_ms + st.global_ms);
+    LOG_INFO("  partition %.2f ms (%.2f%% links cut, imbalance %.2f), local %.2f ms, "
+             "reduce %.2f ms, global %.2f ms\n",
+             ps.ms, 100.0 * ps.cut_fraction, ps.imbalance,
+             st.local_ms, st.reduce_ms, st.global_ms);
+    LOG_INFO("  reduced graph: %d kept nodes, %d hubs, %d links\n",
+             st.kept, st.hubs, st.reduced_m / 2);
+    LOG_INFO("Peak RSS: %ld KB\n", peak_rss_kb());
+  }
+
+  numa_free(part, node_bytes);
+  free(cut);
+  munmap(base, length);
+  return count;
+}
+
+/* ----------------- Stress benchmark ------------------ */
+
+/* Runs every adversarial family through the detection and healing phases
+ * and reports time and memory per phase. Memory is what each phase
+ * actually consumed: adjacency entries for generation, call-stack bytes
+ * and edge-stack high-water for Tarjan, and the process peak RSS. */
+void run_stress_benchmark(void) {
+  printf("\n%-12s %6s %6s %5s | %8s %8s %8s %8s | %6s %9s %9s %5s | %6s %5s %5s | %8s\n",
+         "family", "nodes", "edges", "drop",
+         "gen ms", "tarjan", "heal", "verify",
+         "depth", "stack KB", "bstack KB", "ovf",
+         "leaves", "cut0", "cut1", "rss KB");
+
+  for(int k=0; k<TOPO_COUNT; k++) {
+    topology_kind = (topology_kind_t)k;
+    init_arrays();
+
+    double start = get_time_ms();
+    generate_topology();
+    double t_gen = get_time_ms() - start;
+
+    start = get_time_ms();
+    find_biconnected_components();
+    double t_tarjan = get_time_ms() - start;
+
+    int depth = dfs_depth_peak;
+    long call_stack = (dfs_stack_base && dfs_stack_deepest) ?
+                      (long)(dfs_stack_base - dfs_stack_deepest) : 0;
+    long estack = block_stack_bytes();
+    int ovf = stack_overflows;
+
+    int cut0 = 0;
+    for(int i=0; i<n_nodes; i++) if(is_cut[i]) cut0++;
+
+    start = get_time_ms();
+    add_optimal_redundant_edges();
+    double t_heal = get_time_ms() - start;
+
+    start = get_time_ms();
+    find_cut_vertices();
+    double t_verify = get_time_ms() - start;
+
+    int cut1 = 0;
+    for(int i=0; i<n_nodes; i++) if(is_cut[i]) cut1++;
+
+    printf("%-12s %6d %6d %5d | %8.2f %8.2f %8.2f %8.2f | %6d %9.1f %9.1f %5d | %6d %5d %5d | %8ld\n",
+           topology_names[k], n_nodes, original_edges, dropped_edges,
+           t_gen, t_tarjan, t_heal, t_verify,
+           depth, call_stack / 1024.0, estack / 1024.0, ovf,
+           num_leaf_blocks, cut0, cut1, peak_rss_kb());
+  }
+  printf("\n");
+}
+
 /* ----------------- Main algorithm ------------------ */
 
+/* Verification pass after healing. Only is_cut and the block count are
+ * read afterwards, so it runs a cut-vertex-only engine: the lowpoint DFS
+ * without block extraction, or the chain decomposition, where every
+ * bridge and every cycle chain is exactly one block. */
+void analyse_final_graph(void) {
+  if(engine_auto) {
+    auto_final_analysis();
+  } else if(analysis_engine == ENGINE_CHAIN) {
+    CsrGraph g;
+    ChainResult res;
+    csr_from_graph(&g);
+    chain_cut_vertices(&g, is_cut, &res);
+    num_blocks = res.bridges + res.cycles;
+    blocks_valid = 0;
+  } else {
+    find_cut_vertices();
+  }
+}
+
+void finish_meshification(double start_total, double export_time1);
+
+/* Augmentation and verification, then repair rounds for pairings that
+ * left cut vertices behind */
+void heal_graph(void) {
+  double start = get_time_ms();
+  add_optimal_redundant_edges();
+  time_redundancy_addition = get_time_ms() - start;
+  
+  start = get_time_ms();
+  analyse_final_graph();
+  time_final_analysis = get_time_ms() - start;
+  
+  for(int round=1; round<heal_rounds; round++) {
+    int remaining = 0;
+    for(int i=0; i<n_nodes; i++) if(is_cut[i]) remaining++;
+    if(remaining == 0) break;
+    
+    LOG_INFO("Heal round %d: %d cut vertices remain\n", round + 1, remaining);
+    start = get_time_ms();
+    add_optimal_redundant_edges();
+    time_redundancy_addition += get_time_ms() - start;
+    
+    start = get_time_ms();
+    analyse_final_graph();
+    time_final_analysis += get_time_ms() - start;
+  }
+}
+
 void run_meshification(void) {
   double start_total = get_time_ms();
   
@@ -486,9 +5977,11 @@ void run_meshification(void) {
   
   /* Topology generation */
   double start = get_time_ms();
-  generate_random_topology();
+  generate_topology();
   time_topology_gen = get_time_ms() - start;
   
+  if(export_csr_file) export_csr_graph(export_csr_file);
+  
   /* Initial analysis */
   start = get_time_ms();
   find_biconnected_components();
@@ -498,6 +5991,7 @@ void run_meshification(void) {
   for(int i=0; i<n_nodes; i++) if(is_cut[i]) initial_cut_vertices++;
   
   LOG_INFO("Initial: %d cut vertices, %d blocks\n", initial_cut_vertices, num_blocks);
+  routing_load(load_initial, rank_initial, rpl_parent_initial, &load_stats[0]);
   
   /* Export original */
   start = get_time_ms();
@@ -506,21 +6000,21 @@ void run_meshification(void) {
   
   /* Add redundancy if needed */
   if(initial_cut_vertices > 0) {
-    start = get_time_ms();
-    add_optimal_redundant_edges();
-    time_redundancy_addition = get_time_ms() - start;
-    
-    start = get_time_ms();
-    find_biconnected_components();
-    time_final_analysis = get_time_ms() - start;
+    heal_graph();
   } else {
     LOG_INFO("Graph is already biconnected!\n");
     time_redundancy_addition = 0.0;
     time_final_analysis = 0.0;
   }
   
+  finish_meshification(start_total, export_time1);
+}
+
+/* Final export, metrics and report of the one-shot run; the
+ * cooperative run goes through the same steps in slices */
+void finish_meshification(double start_total, double export_time1) {
   /* Export final */
-  start = get_time_ms();
+  double start = get_time_ms();
   export_dot_graph("dodag_final.dot", 1);
   double export_time2 = get_time_ms() - start;
   
@@ -528,6 +6022,13 @@ void run_meshification(void) {
   
   /* Compute metrics */
   compute_network_metrics();
+  routing_load(load_final, rank_final, rpl_parent_final, &load_stats[1]);
+  export_rpl_tree("dodag_rpl.txt");
+  hop_depths_compare();
+  
+  /* Final cut flags become visible to result_query(); block ids only
+   * if the final analysis already built them */
+  result_publish(0);
   
   /* Generate images */
   generate_images();
@@ -536,6 +6037,1116 @@ void run_meshification(void) {
   
   /* Print statistics */
   print_statistics();
+  print_routing_load();
+  print_hop_report();
+  print_autotune_report();
+  print_engine_report();
+}
+
+/* ----------------- Determinism check ------------------ */
+
+/* Everything a run exports, in canonical order: the healed graph as
+ * dot text, then per node its cut flag, block id, forwarding load, ETX
+ * rank and RPL parent, and hop depths before and after healing */
+static void write_canonical_results(FILE *f) {
+  write_dot_graph(f, 1);
+  fprintf(f, "# node cut block load rank parent hops-before hops-after\n");
+  for(int v=0; v<n_nodes; v++) {
+    int block;
+    int cut = result_query(v, &block, NULL);
+    fprintf(f, "%d %d %d %d %d %d %d %d\n", v, cut, block, load_final[v], rank_final[v],
+            rpl_parent_final[v], hop_before[v], hop_after[v]);
+  }
+}
+
+/* Line number of the first difference, 0 if a and b are identical */
+static int first_difference(const char *a, size_t alen, const char *b, size_t blen) {
+  int line = 1;
+  for(size_t i=0; i<alen || i<blen; i++) {
+    if(i >= alen || i >= blen || a[i] != b[i]) return line;
+    if(a[i] == '\n') line++;
+  }
+  return 0;
+}
+
+/* Generates, heals and analyses the same topology at 1 .. max_threads
+ * threads, with the small-input thresholds off so every parallel path
+ * runs, and compares each run's canonical export byte for byte with
+ * the single-threaded one. Returns the number of differing runs. */
+int run_determinism_check(int max_threads) {
+  int saved_threads = num_threads, saved_nodes = n_nodes, failures = 0;
+  char *reference = NULL;
+  size_t ref_len = 0;
+
+  if(topology_seed == 0) topology_seed = (unsigned int)time(NULL) ^ (unsigned int)clock();
+  force_parallel = 1;
+  LOG_INFO("Determinism check: seed %u, 1 to %d threads\n", topology_seed, max_threads);
+
+  printf("\n%8s %10s %10s %8s %s\n", "threads", "bytes", "hash", "cuts", "export");
+  for(int t=1; t<=max_threads; t++) {
+    num_threads = t;
+    n_nodes = saved_nodes;
+    init_arrays();
+    generate_topology();
+    find_biconnected_components();
+    initial_cut_vertices = 0;
+    for(int i=0; i<n_nodes; i++) if(is_cut[i]) initial_cut_vertices++;
+    routing_load(load_initial, rank_initial, rpl_parent_initial, &load_stats[0]);
+    if(initial_cut_vertices > 0) heal_graph();
+    compute_network_metrics();
+    routing_load(load_final, rank_final, rpl_parent_final, &load_stats[1]);
+    hop_depths_compare();
+    result_publish(1);
+
+    char *text = NULL;
+    size_t len = 0;
+    FILE *f = open_memstream(&text, &len);
+    if(!f) {
+      LOG_ERR("Failed to open export buffer\n");
+      failures++;
+      break;
+    }
+    write_canonical_results(f);
+    fclose(f);
+
+    unsigned int hash = 2166136261U;
+    for(size_t i=0; i<len; i++) hash = (hash ^ (unsigned char)text[i]) * 16777619U;
+
+    int diff = reference ? first_difference(reference, ref_len, text, len) : 0;
+    printf("%8d %10zu   %08x %8d ", t, len, hash, final_cut_vertices);
+    if(!reference) {
+      printf("reference\n");
+      reference = text;
+      ref_len = len;
+      continue;
+    }
+    if(diff) {
+      printf("DIFFERS from line %d\n", diff);
+      failures++;
+    } else {
+      printf("identical\n");
+    }
+    free(text);
+  }
+  free(reference);
+
+  printf("%s\n\n", failures ? "Thread count changes the results" :
+                               "Results are identical at every thread count");
+  num_threads = saved_threads;
+  n_nodes = saved_nodes;
+  force_parallel = 0;
+  return failures;
+}
+
+/* ----------------- Cooperative analysis ------------------ */
+
+/* run_meshification() as a state machine that the Contiki process
+ * drives one time slice per poll, yielding in between so the network
+ * stack keeps running. Every phase is split into units of bounded work:
+ * COOP_STEPS steps of a walk (the Tarjan or chain verification, the BFS
+ * and Dial passes of the routing load, the fused hop-depth BFS),
+ * COOP_ROWS rows of a per-node pass (dot and RPL exports, CSR snapshot,
+ * metrics, publication), one planned link, or one block published.
+ * Topology generation, one planning pass and the final report are
+ * single units, and starting a pass clears its O(n) scratch in one
+ * unit. Image rendering runs as a child process that later slices poll.
+ * A slice runs units until coop_slice_ms has passed, so it overruns the
+ * budget by at most one unit, and every unit counts towards the worst
+ * slice and unit reported. All state is static, as protothreads keep no
+ * locals across a yield. */
+#define COOP_STEPS 64
+#define COOP_ROWS 64
+
+typedef enum {
+  COOP_GENERATE = 0,  /* topology, one unit */
+  COOP_INITIAL,       /* block-extracting DFS of the original graph */
+  COOP_EXPORT,        /* dodag_old.dot */
+  COOP_LOAD,          /* initial routing load */
+  COOP_PLAN,          /* leaf blocks, candidates and pairing */
+  COOP_LINKS,         /* one planned link per unit */
+  COOP_VERIFY,        /* cut-vertex-only pass with the --engine engine */
+  COOP_REBLOCK,       /* block-extracting DFS before a repair round */
+  COOP_FINAL_EXPORT,  /* dodag_final.dot */
+  COOP_METRICS,
+  COOP_FINAL_LOAD,    /* routing load of the healed graph */
+  COOP_RPL_EXPORT,    /* dodag_rpl.txt */
+  COOP_HOPS,          /* hop depths before and after */
+  COOP_PUBLISH,       /* final cut flags for result_query() */
+  COOP_IMAGES,        /* waits on the renderer without blocking */
+  COOP_REPORT,        /* statistics, one unit */
+  COOP_DONE
+} coop_phase_t;
+
+static const char *coop_phase_names[] = {
+  "generate", "initial", "export", "load", "plan", "links", "verify", "reblock",
+  "final-export", "metrics", "final-load", "rpl-export", "hops", "publish",
+  "images", "report", "done"
+};
+
+static coop_phase_t coop_phase, coop_worst_phase;
+static int coop_started;             /* the current phase has set up */
+static int coop_row;
+static int coop_yield;               /* end the slice after this unit */
+static int coop_stack[MAX_NODES];
+static int coop_cursor[MAX_NODES];
+static int coop_sp, coop_root, coop_next_root, coop_root_children, coop_blocks;
+static int coop_link, coop_nlinks, coop_round, coop_added, coop_paths;
+static double coop_start_total, coop_export_old, coop_export_final, coop_other;
+static int coop_slices;
+static double coop_busy, coop_worst_slice, coop_worst_unit, coop_longest_pause, coop_last_end;
+static FILE *coop_file;
+static LoadRun coop_load;
+static HopRun coop_hops;
+static int coop_buffer;              /* result buffer being filled */
+static pid_t coop_render;
+static double coop_render_start;
+
+/* Chain decomposition state: disc[] holds the preorder index + 1 and
+ * parent_tarjan[] the DFS tree, as in chain_cut_vertices() */
+static int coop_chain;               /* 0 off, else 1 + current stage */
+static int coop_order[MAX_NODES];
+static char coop_seen[MAX_NODES];
+static int coop_time, coop_k, coop_i, coop_x, coop_component_chains;
+static int coop_bridges, coop_cycles;
+
+static void coop_enter(coop_phase_t phase) {
+  coop_phase = phase;
+  coop_started = 0;
+  coop_row = 0;
+}
+
+static void coop_dfs_start(int with_blocks) {
+  memset(visited, 0, sizeof(visited));
+  memset(parent_tarjan, -1, sizeof(parent_tarjan));
+  memset(disc, 0, sizeof(disc));
+  memset(low, 0, sizeof(low));
+  memset(is_cut, 0, sizeof(is_cut));
+  if(with_blocks) memset(block_size, 0, sizeof(block_size));
+
+  num_blocks = 0;
+  blocks_valid = 0;
+  vstack_top = 0;
+  time_dfs = 0;
+  stack_peak = 0;
+  dfs_depth_peak = 0;
+  coop_sp = 0;
+  coop_next_root = 0;
+  coop_blocks = with_blocks;
+  coop_chain = 0;
+}
+
+/* Up to steps steps of tarjan_dfs_vstack() made iterative, with the
+ * same blocks in the same order. Returns 1 once every node is done. */
+static int coop_dfs_run(int steps) {
+  while(steps-- > 0) {
+    if(coop_sp == 0) {
+      while(coop_next_root < n_nodes && visited[coop_next_root]) coop_next_root++;
+      if(coop_next_root == n_nodes) {
+        if(coop_blocks) canonical_blocks();
+        blocks_valid = coop_blocks;
+        return 1;
+      }
+      int r = coop_next_root;
+      coop_root = r;
+      coop_root_children = 0;
+      visited[r] = 1;
+      disc[r] = low[r] = ++time_dfs;
+      coop_cursor[r] = 0;
+      coop_stack[coop_sp++] = r;
+      vstack_top = 0;
+      if(coop_blocks) vertex_stack[vstack_top++] = r;
+      continue;
+    }
+
+    int u = coop_stack[coop_sp - 1];
+    if(coop_cursor[u] < degree[u]) {
+      int v = neighbors[u][coop_cursor[u]++];
+      if(!visited[v]) {
+        if(u == coop_root) coop_root_children++;
+        parent_tarjan[v] = u;
+        visited[v] = 1;
+        disc[v] = low[v] = ++time_dfs;
+        coop_cursor[v] = 0;
+        coop_stack[coop_sp++] = v;
+        if(coop_sp > dfs_depth_peak) dfs_depth_peak = coop_sp;
+        if(coop_blocks) {
+          vertex_stack[vstack_top++] = v;
+          if(vstack_top > stack_peak) stack_peak = vstack_top;
+        }
+      } else if(v != parent_tarjan[u] && disc[v] < low[u]) {
+        low[u] = disc[v];
+      }
+      continue;
+    }
+
+    coop_sp--;
+    int p = parent_tarjan[u];
+    if(p < 0) continue;
+    if(low[u] < low[p]) low[p] = low[u];
+    if(low[u] >= disc[p]) {
+      if(p != coop_root || coop_root_children > 1) is_cut[p] = 1;
+      if(coop_blocks) {
+        int w;
+        if(num_blocks < MAX_BLOCKS) {
+          do {
+            w = vertex_stack[--vstack_top];
+            block_nodes[num_blocks][block_size[num_blocks]++] = w;
+          } while(w != u);
+          block_nodes[num_blocks][block_size[num_blocks]++] = p;
+          num_blocks++;
+        } else {
+          do { w = vertex_stack[--vstack_top]; } while(w != u);
+        }
+      } else {
+        num_blocks++;
+      }
+    }
+  }
+  return 0;
+}
+
+static int coop_count_cut(void) {
+  int count = 0;
+  for(int i=0; i<n_nodes; i++) if(is_cut[i]) count++;
+  return count;
+}
+
+/* chain_cut_vertices() over the static adjacency in steps */
+static void coop_chain_start(void) {
+  memset(disc, 0, sizeof(disc));
+  memset(parent_tarjan, -1, sizeof(parent_tarjan));
+  memset(coop_seen, 0, sizeof(coop_seen));
+  memset(is_cut, 0, sizeof(is_cut));
+  coop_sp = 0;
+  coop_next_root = 0;
+  coop_time = 0;
+  coop_bridges = coop_cycles = 0;
+  coop_chain = 1;
+}
+
+/* Up to steps steps: a DFS step, a back edge looked at, a chain walk
+ * step or a bridge test. Returns 1 once is_cut and num_blocks are set. */
+static int coop_chain_run(int steps) {
+  while(steps-- > 0) {
+    if(coop_chain == 1) {
+      /* Phase 1: DFS preorder and tree */
+      if(coop_sp == 0) {
+        while(coop_next_root < n_nodes && disc[coop_next_root]) coop_next_root++;
+        if(coop_next_root == n_nodes) {
+          coop_k = 0;
+          coop_i = -1;
+          coop_x = -1;
+          coop_chain = 2;
+          continue;
+        }
+        int r = coop_next_root;
+        disc[r] = ++coop_time;
+        coop_order[coop_time - 1] = r;
+        coop_cursor[r] = 0;
+        coop_stack[coop_sp++] = r;
+        continue;
+      }
+      int u = coop_stack[coop_sp - 1];
+      if(coop_cursor[u] < degree[u]) {
+        int v = neighbors[u][coop_cursor[u]++];
+        if(!disc[v]) {
+          parent_tarjan[v] = u;
+          disc[v] = ++coop_time;
+          coop_order[coop_time - 1] = v;
+          coop_cursor[v] = 0;
+          coop_stack[coop_sp++] = v;
+        }
+      } else {
+        coop_sp--;
+      }
+      continue;
+    }
+
+    if(coop_chain == 2) {
+      /* Phase 2: chains in preorder of their start vertex */
+      if(coop_x >= 0) {
+        if(!coop_seen[coop_x]) {
+          coop_seen[coop_x] = CHAIN_COVERED;
+          coop_x = parent_tarjan[coop_x];
+          continue;
+        }
+        int v = coop_order[coop_k];
+        if(coop_x == v) {
+          coop_cycles++;
+          if(coop_component_chains > 0) is_cut[v] = 1;
+        }
+        coop_component_chains++;
+        coop_x = -1;
+        continue;
+      }
+      if(coop_k == n_nodes) {
+        coop_k = 0;
+        coop_chain = 3;
+        continue;
+      }
+      int v = coop_order[coop_k];
+      if(coop_i < 0) {
+        if(parent_tarjan[v] == -1) coop_component_chains = 0;
+        coop_i = 0;
+      }
+      if(coop_i == degree[v]) {
+        coop_k++;
+        coop_i = -1;
+        continue;
+      }
+      int w = neighbors[v][coop_i++];
+      if(disc[w] <= disc[v] || parent_tarjan[w] == v) continue;
+      if(!coop_seen[v]) coop_seen[v] = CHAIN_START;
+      coop_x = w;
+      continue;
+    }
+
+    /* Phase 3: uncovered tree edges are bridges */
+    if(coop_k == n_nodes) {
+      num_blocks = coop_bridges + coop_cycles;
+      blocks_valid = 0;
+      return 1;
+    }
+    int x = coop_k++;
+    int p = parent_tarjan[x];
+    if(p < 0 || coop_seen[x] == CHAIN_COVERED) continue;
+    coop_bridges++;
+    if(degree[p] >= 2) is_cut[p] = 1;
+    if(degree[x] >= 2) is_cut[x] = 1;
+  }
+  return 0;
+}
+
+/* Starts the verification pass with the engine the one-shot run would
+ * use. --engine=auto takes the recorded decision for the graph class;
+ * calibrating would time every engine in one unit, so without one the
+ * lowpoint walk runs. */
+static void coop_verify_start(void) {
+  int chain = analysis_engine == ENGINE_CHAIN;
+  if(engine_auto) {
+    int e = auto_final_engine_recorded();
+    if(e < 0) LOG_INFO("No engine recorded for this graph class; verifying with the lowpoint walk\n");
+    chain = e == FINAL_CHAIN;
+  }
+  if(chain) {
+    coop_chain_start();
+  } else {
+    coop_dfs_start(0);
+  }
+}
+
+/* Up to COOP_ROWS rows of a dot export; returns 1 once the file is
+ * written or could not be opened */
+static int coop_export_dot(const char *fname, int show_redundant) {
+  if(!coop_file) {
+    coop_file = fopen(fname, "w");
+    if(!coop_file) {
+      LOG_ERR("Failed to open %s\n", fname);
+      return 1;
+    }
+    write_dot_header(coop_file);
+  }
+  for(int i=0; i<COOP_ROWS && coop_row<2*n_nodes; i++) {
+    write_dot_row(coop_file, show_redundant, coop_row++);
+  }
+  if(coop_row < 2 * n_nodes) return 0;
+  fprintf(coop_file, "}\n");
+  fclose(coop_file);
+  coop_file = NULL;
+  LOG_INFO("Exported %s\n", fname);
+  return 1;
+}
+
+static int coop_rows_end(void) {
+  return coop_row + COOP_ROWS < n_nodes ? coop_row + COOP_ROWS : n_nodes;
+}
+
+/* One unit of work; returns the timer the unit counts towards */
+static double *coop_unit(void) {
+  switch(coop_phase) {
+  case COOP_GENERATE: {
+    init_arrays();
+    double start = get_time_ms();
+    generate_topology();
+    time_topology_gen = get_time_ms() - start;
+    if(export_csr_file) export_csr_graph(export_csr_file);
+    coop_dfs_start(1);
+    coop_enter(COOP_INITIAL);
+    return &coop_other;
+  }
+
+  case COOP_INITIAL:
+    if(coop_dfs_run(COOP_STEPS)) {
+      initial_cut_vertices = coop_count_cut();
+      LOG_INFO("Initial: %d cut vertices, %d blocks\n", initial_cut_vertices, num_blocks);
+      coop_enter(COOP_EXPORT);
+    }
+    return &time_initial_analysis;
+
+  case COOP_EXPORT:
+    if(coop_export_dot("dodag_old.dot", 0)) coop_enter(COOP_LOAD);
+    return &coop_export_old;
+
+  case COOP_LOAD:
+    if(!coop_started) {
+      load_begin(&coop_load, load_initial, rank_initial, rpl_parent_initial, &load_stats[0]);
+      coop_started = 1;
+    } else if(load_run(&coop_load, COOP_STEPS)) {
+      if(initial_cut_vertices > 0) {
+        coop_enter(COOP_PLAN);
+      } else {
+        LOG_INFO("Graph is already biconnected!\n");
+        coop_enter(COOP_FINAL_EXPORT);
+      }
+    }
+    return &coop_other;
+
+  case COOP_PLAN:
+    identify_leaf_blocks();
+    LOG_INFO("Found %d leaf blocks (need %d edges)\n",
+             num_leaf_blocks, (num_leaf_blocks + 1) / 2);
+    select_leaf_candidates();
+    coop_nlinks = plan_leaf_links(leaf_links);
+    if(augment_mode == AUGMENT_RELAY) build_relay_grid();
+    coop_link = 0;
+    coop_added = coop_paths = 0;
+    coop_enter(COOP_LINKS);
+    return &time_redundancy_addition;
+
+  case COOP_LINKS:
+    if(coop_link < coop_nlinks) {
+      Edge e = leaf_links[coop_link++];
+      if(augment_mode == AUGMENT_RELAY) {
+        int hops = add_relay_path(e.u, e.v);
+        coop_added += hops;
+        coop_paths += hops > 0;
+      } else {
+        coop_added += add_redundant_edge(e.u, e.v);
+      }
+      return &time_redundancy_addition;
+    }
+    LOG_INFO("Added %d optimal redundant edges (%.1f m of links)\n",
+             coop_added, added_link_length);
+    if(augment_mode == AUGMENT_RELAY) {
+      LOG_INFO("Placed %d relay nodes on %d paths, %d nodes total\n",
+               relays_added, coop_paths, n_nodes);
+    }
+    coop_enter(COOP_VERIFY);
+    return &time_redundancy_addition;
+
+  case COOP_VERIFY:
+    if(!coop_started) {
+      coop_verify_start();
+      coop_started = 1;
+    } else if(coop_chain ? coop_chain_run(COOP_STEPS) : coop_dfs_run(COOP_STEPS)) {
+      int remaining = coop_count_cut();
+      if(remaining > 0 && ++coop_round < heal_rounds) {
+        LOG_INFO("Heal round %d: %d cut vertices remain\n", coop_round + 1, remaining);
+        coop_dfs_start(1);
+        coop_enter(COOP_REBLOCK);
+      } else {
+        coop_enter(COOP_FINAL_EXPORT);
+      }
+    }
+    return &time_final_analysis;
+
+  case COOP_REBLOCK:
+    if(coop_dfs_run(COOP_STEPS)) coop_enter(COOP_PLAN);
+    return &time_redundancy_addition;
+
+  case COOP_FINAL_EXPORT:
+    if(coop_export_dot("dodag_final.dot", 1)) coop_enter(COOP_METRICS);
+    return &coop_export_final;
+
+  case COOP_METRICS:
+    if(!coop_started) {
+      network_metrics_begin();
+      coop_started = 1;
+    }
+    network_metrics_rows(coop_row, coop_rows_end());
+    coop_row = coop_rows_end();
+    if(coop_row == n_nodes) {
+      network_metrics_finish();
+      coop_enter(COOP_FINAL_LOAD);
+    }
+    return &coop_other;
+
+  case COOP_FINAL_LOAD:
+    if(!coop_started) {
+      load_begin(&coop_load, load_final, rank_final, rpl_parent_final, &load_stats[1]);
+      coop_started = 1;
+    } else if(load_run(&coop_load, COOP_STEPS)) {
+      coop_enter(COOP_RPL_EXPORT);
+    }
+    return &coop_other;
+
+  case COOP_RPL_EXPORT:
+    if(!coop_file) {
+      coop_file = fopen("dodag_rpl.txt", "w");
+      if(!coop_file) {
+        LOG_ERR("Failed to open dodag_rpl.txt\n");
+        coop_enter(COOP_HOPS);
+        return &coop_other;
+      }
+      write_rpl_header(coop_file);
+    }
+    for(int v=coop_row; v<coop_rows_end(); v++) write_rpl_row(coop_file, v);
+    coop_row = coop_rows_end();
+    if(coop_row == n_nodes) {
+      fclose(coop_file);
+      coop_file = NULL;
+      LOG_INFO("Exported dodag_rpl.txt\n");
+      coop_enter(COOP_HOPS);
+    }
+    return &coop_other;
+
+  case COOP_HOPS:
+    /* The final load's CSR snapshot is still that of the healed graph */
+    if(coop_started == 0) {
+      hop_separate = coop_load.g.m;
+      coop_started = 1;
+    }
+    if(coop_started == 1) {
+      hop_separate += hop_bit_rows(&coop_load.g, coop_row, coop_rows_end());
+      coop_row = coop_rows_end();
+      if(coop_row == n_nodes) {
+        hop_begin(&coop_hops, &coop_load.g, hop_bits, hop_before, hop_after);
+        coop_started = 2;
+      }
+    } else if(hop_run(&coop_hops, COOP_STEPS)) {
+      hop_scans = coop_hops.scans;
+      coop_enter(COOP_PUBLISH);
+    }
+    return &coop_other;
+
+  case COOP_PUBLISH:
+    /* Final cut flags become visible to result_query(); block ids only
+     * if the final analysis already built them */
+    if(!coop_started) {
+      coop_buffer = result_publish_begin(0);
+      coop_started = 1;
+    }
+    if(coop_row < n_nodes) {
+      result_publish_rows(coop_buffer, coop_row, coop_rows_end());
+      coop_row = coop_rows_end();
+      if(coop_row == n_nodes) coop_row = n_nodes + (blocks_valid ? num_blocks : 0);
+    } else if(coop_row > n_nodes) {
+      result_publish_block(coop_buffer, --coop_row - n_nodes);
+    } else {
+      result_publish_end(coop_buffer);
+      coop_enter(COOP_IMAGES);
+    }
+    return &coop_other;
+
+  case COOP_IMAGES:
+    if(!coop_started) {
+      char *argv[] = { "sh", "-c", RENDER_COMMAND, NULL };
+      LOG_INFO("Generating PNG images...\n");
+      coop_render_start = get_time_ms();
+      coop_started = 1;
+      if(posix_spawn(&coop_render, "/bin/sh", NULL, NULL, argv, environ) != 0) {
+        report_images(0, 0.0);
+        coop_enter(COOP_REPORT);
+      }
+    } else {
+      int status;
+      pid_t r = waitpid(coop_render, &status, WNOHANG);
+      if(r == 0) {
+        /* Still rendering; give the rest of the slice back */
+        coop_yield = 1;
+      } else {
+        report_images(r == coop_render && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+                      get_time_ms() - coop_render_start);
+        coop_enter(COOP_REPORT);
+      }
+    }
+    return &coop_other;
+
+  case COOP_REPORT:
+    time_dot_export = coop_export_old + coop_export_final;
+    time_total = get_time_ms() - coop_start_total;
+    print_statistics();
+    print_routing_load();
+    print_hop_report();
+    print_autotune_report();
+    print_engine_report();
+    coop_enter(COOP_DONE);
+    return &coop_other;
+
+  default:
+    return &coop_other;
+  }
+}
+
+/* Sets up the first phase; the topology is generated by the first unit */
+void coop_begin(void) {
+  coop_start_total = get_time_ms();
+  LOG_INFO("Starting cooperative meshification (%.2f ms slices)...\n", coop_slice_ms);
+
+  time_initial_analysis = time_redundancy_addition = time_final_analysis = 0.0;
+  coop_export_old = coop_export_final = coop_other = 0.0;
+  coop_file = NULL;
+  coop_round = 0;
+  coop_slices = 0;
+  coop_busy = coop_worst_slice = coop_worst_unit = coop_longest_pause = 0.0;
+  coop_worst_phase = COOP_GENERATE;
+  coop_enter(COOP_GENERATE);
+}
+
+/* Runs units for one time slice; returns 1 once the run is done */
+int coop_step(void) {
+  double slice_start = get_time_ms();
+  if(coop_slices > 0 && slice_start - coop_last_end > coop_longest_pause) {
+    coop_longest_pause = slice_start - coop_last_end;
+  }
+
+  double now = slice_start;
+  coop_yield = 0;
+  do {
+    double unit_start = now;
+    coop_phase_t phase = coop_phase;
+    double *timer = coop_unit();
+    now = get_time_ms();
+    *timer += now - unit_start;
+    if(now - unit_start > coop_worst_unit) {
+      coop_worst_unit = now - unit_start;
+      coop_worst_phase = phase;
+    }
+  } while(coop_phase != COOP_DONE && !coop_yield && now - slice_start < coop_slice_ms);
+
+  double slice = now - slice_start;
+  coop_busy += slice;
+  if(slice > coop_worst_slice) coop_worst_slice = slice;
+  coop_slices++;
+  coop_last_end = now;
+  return coop_phase == COOP_DONE;
+}
+
+void coop_finish(void) {
+  printf("Cooperative analysis: %d slices of %.2f ms, %.2f ms busy\n",
+         coop_slices, coop_slice_ms, coop_busy);
+  printf("  worst slice %.3f ms, mean %.3f ms, longest unit %.3f ms (%s), longest pause %.3f ms\n\n",
+         coop_worst_slice, coop_slices ? coop_busy / coop_slices : 0.0,
+         coop_worst_unit, coop_phase_names[coop_worst_phase], coop_longest_pause);
+}
+
+/* ----------------- Mote simulation ------------------ */
+
+/* Lightweight in-process emulation of one mote per node, wired by the
+ * generated graph. Motes build a DODAG from root 0 with periodic DIO
+ * beacons, report their position in it to the root with DAOs forwarded
+ * hop by hop. Once every mote has reported and reports have gone quiet
+ * for one analysis interval, the root analyses and sends each planned
+ * link to both endpoints down the tree. A command whose route broke
+ * because the DODAG changed under it goes back to the root, which
+ * re-sends it down the current tree, waiting a beacon interval while
+ * the endpoint has no route. A link (or relay path, with
+ * --augment=relay) is added once both endpoints hold the command.
+ * Everything is a timestamped event in one binary heap, so the run is
+ * deterministic and as fast as the events can be processed. */
+#define SIM_HOP_MS 8.0           /* airtime per hop */
+#define SIM_BACKOFF_MS 8.0       /* CSMA backoff, uniform 0..this */
+#define SIM_DIO_INTERVAL 4.0     /* s between beacons once joined */
+#define SIM_DAO_DELAY 0.5        /* s after a parent change */
+#define SIM_ANALYSE_INTERVAL 2.0 /* s between root analysis checks */
+#define SIM_UNRANKED INT_MAX
+
+typedef enum { SIM_DIO_TIMER = 0, SIM_DIO, SIM_DAO_TIMER, SIM_DAO, SIM_ANALYSE, SIM_HEAL } sim_kind_t;
+
+typedef struct {
+  double t;
+  long seq;            /* tie-break, keeps the order deterministic */
+  sim_kind_t kind;
+  int node;            /* receiving or timer mote */
+  int a;               /* DIO: sender rank; DAO: origin; HEAL: destination */
+  int b;               /* DIO: sender; DAO: generation; HEAL: link index */
+} SimEvent;
+
+static SimEvent *sim_heap;
+static int sim_heap_len, sim_heap_cap;
+static long sim_seq;
+static int sim_rank[MAX_NODES];
+static int sim_parent[MAX_NODES];
+static int sim_dao_gen[MAX_NODES];
+static char sim_reported[MAX_NODES];
+static char sim_heal_seen[MAX_BLOCKS / 2 + 1][2];
+
+static int sim_before(const SimEvent *x, const SimEvent *y) {
+  return x->t < y->t || (x->t == y->t && x->seq < y->seq);
+}
+
+static int sim_push(double t, sim_kind_t kind, int node, int a, int b) {
+  if(sim_heap_len == sim_heap_cap) {
+    int cap = sim_heap_cap ? 2 * sim_heap_cap : 4096;
+    SimEvent *h = realloc(sim_heap, sizeof(SimEvent) * (size_t)cap);
+    if(!h) return -1;
+    sim_heap = h;
+    sim_heap_cap = cap;
+  }
+  SimEvent e = { t, sim_seq++, kind, node, a, b };
+  int i = sim_heap_len++;
+  while(i > 0 && sim_before(&e, &sim_heap[(i - 1) / 2])) {
+    sim_heap[i] = sim_heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  sim_heap[i] = e;
+  return 0;
+}
+
+static SimEvent sim_pop(void) {
+  SimEvent top = sim_heap[0];
+  SimEvent last = sim_heap[--sim_heap_len];
+  int i = 0;
+  for(;;) {
+    int c = 2 * i + 1;
+    if(c >= sim_heap_len) break;
+    if(c + 1 < sim_heap_len && sim_before(&sim_heap[c + 1], &sim_heap[c])) c++;
+    if(!sim_before(&sim_heap[c], &last)) break;
+    sim_heap[i] = sim_heap[c];
+    i = c;
+  }
+  if(sim_heap_len > 0) sim_heap[i] = last;
+  return top;
+}
+
+/* Delay of one transmission, airtime plus a hashed backoff */
+static inline double sim_hop_delay(void) {
+  return (SIM_HOP_MS + SIM_BACKOFF_MS * (hash_u32((unsigned int)sim_seq) & 0xffff) / 65536.0) / 1000.0;
+}
+
+/* Next hop from x toward descendant d: the child of x on d's parent chain */
+static int sim_next_hop_down(int x, int d) {
+  while(d != -1 && sim_parent[d] != x) d = sim_parent[d];
+  return d;
+}
+
+void run_mote_simulation(double seconds) {
+  long msgs[6] = { 0 };
+  long events = 0;
+  int joined = 0, reports = 0, heal_links = 0, heal_done = 0, heal_refused = 0;
+  long heal_reroutes = 0;
+  int rounds = 0, round_links = 0, round_done = 0, cut_at_detect = -1;
+  double t_joined = -1, t_reports = -1, t_detect = -1, t_healed = -1, last_report = 0;
+  const char *kind_names[] = { "DIO timer", "DIO", "DAO timer", "DAO", "analysis", "HEAL" };
+
+  init_arrays();
+  generate_topology();
+
+  for(int i=0; i<n_nodes; i++) {
+    sim_rank[i] = SIM_UNRANKED;
+    sim_parent[i] = -1;
+    sim_dao_gen[i] = 0;
+    sim_reported[i] = 0;
+  }
+  sim_heap_len = 0;
+  sim_seq = 0;
+  sim_rank[0] = 0;
+  joined = 1;
+  sim_push(0.0, SIM_DIO_TIMER, 0, 0, 0);
+  sim_push(SIM_ANALYSE_INTERVAL, SIM_ANALYSE, 0, 0, 0);
+
+  double wall_start = get_time_ms();
+  double now = 0.0;
+
+  while(sim_heap_len > 0) {
+    SimEvent e = sim_pop();
+    if(e.t > seconds) break;
+    now = e.t;
+    events++;
+    msgs[e.kind]++;
+    int u = e.node;
+
+    switch(e.kind) {
+    case SIM_DIO_TIMER:
+      for(int i=0; i<degree[u]; i++) {
+        if(sim_push(now + sim_hop_delay(), SIM_DIO, neighbors[u][i], sim_rank[u], u)) goto oom;
+      }
+      if(sim_push(now + SIM_DIO_INTERVAL * (0.5 + 0.5 * (hash_u32((unsigned int)(u + 1) ^ (unsigned int)events) & 0xffff) / 65536.0),
+                  SIM_DIO_TIMER, u, 0, 0)) goto oom;
+      break;
+
+    case SIM_DIO:
+      if(e.a + 1 < sim_rank[u]) {
+        if(sim_rank[u] == SIM_UNRANKED) {
+          if(++joined == n_nodes && t_joined < 0) t_joined = now;
+          if(sim_push(now, SIM_DIO_TIMER, u, 0, 0)) goto oom;
+        }
+        sim_rank[u] = e.a + 1;
+        sim_parent[u] = e.b;
+        if(sim_push(now + SIM_DAO_DELAY, SIM_DAO_TIMER, u, 0, ++sim_dao_gen[u])) goto oom;
+      }
+      break;
+
+    case SIM_DAO_TIMER:
+      if(e.b == sim_dao_gen[u] && sim_parent[u] >= 0) {
+        if(sim_push(now + sim_hop_delay(), SIM_DAO, sim_parent[u], u, e.b)) goto oom;
+      }
+      break;
+
+    case SIM_DAO:
+      if(u == 0) {
+        if(!sim_reported[e.a]) {
+          sim_reported[e.a] = 1;
+          if(++reports == n_nodes - 1 && t_reports < 0) t_reports = now;
+        }
+        last_report = now;
+      } else if(sim_parent[u] >= 0) {
+        if(sim_push(now + sim_hop_delay(), SIM_DAO, sim_parent[u], e.a, e.b)) goto oom;
+      }
+      break;
+
+    case SIM_ANALYSE:
+      /* Analyse only once every mote, relays included, has reported,
+       * so the root's view is the whole graph; then wait for reports to
+       * go quiet for a whole interval and for the previous round's
+       * commands to be delivered */
+      if(reports == n_nodes - 1 && now - last_report >= SIM_ANALYSE_INTERVAL &&
+         round_done == round_links && rounds < heal_rounds) {
+        find_biconnected_components();
+        int cuts = 0;
+        for(int i=0; i<n_nodes; i++) if(is_cut[i]) cuts++;
+        if(rounds == 0) {
+          cut_at_detect = cuts;
+          t_detect = now;
+        }
+        if(cuts == 0) break;
+        rounds++;
+
+        identify_leaf_blocks();
+        select_leaf_candidates();
+        int planned = plan_leaf_links(leaf_links);
+        if(augment_mode == AUGMENT_RELAY) build_relay_grid();
+        memset(sim_heal_seen, 0, sizeof(sim_heal_seen));
+        round_links = round_done = 0;
+        for(int k=0; k<planned; k++) {
+          if(leaf_links[k].u < 0 || leaf_links[k].v < 0) continue;
+          round_links++;
+          /* Both commands start at the root, which routes them down */
+          if(sim_push(now, SIM_HEAL, 0, leaf_links[k].u, k)) goto oom;
+          if(sim_push(now, SIM_HEAL, 0, leaf_links[k].v, k)) goto oom;
+        }
+        heal_links += round_links;
+      }
+      if(sim_push(now + SIM_ANALYSE_INTERVAL, SIM_ANALYSE, 0, 0, 0)) goto oom;
+      break;
+
+    case SIM_HEAL:
+      if(u == e.a) {
+        int end = leaf_links[e.b].v == u;
+        if(sim_heal_seen[e.b][end]) break;
+        sim_heal_seen[e.b][end] = 1;
+        if(sim_heal_seen[e.b][0] && sim_heal_seen[e.b][1]) {
+          int first_new = n_nodes;
+          int added = augment_mode == AUGMENT_RELAY ?
+            add_relay_path(leaf_links[e.b].u, leaf_links[e.b].v) :
+            add_redundant_edge(leaf_links[e.b].u, leaf_links[e.b].v);
+          if(added > 0) heal_done++;
+          else heal_refused++;
+          /* New relays start unjoined and join from their neighbours' beacons */
+          for(int r=first_new; r<n_nodes; r++) {
+            sim_rank[r] = SIM_UNRANKED;
+            sim_parent[r] = -1;
+            sim_dao_gen[r] = 0;
+            sim_reported[r] = 0;
+          }
+          if(++round_done == round_links) t_healed = now;
+        }
+      } else {
+        int hop = sim_next_hop_down(u, e.a);
+        if(hop >= 0) {
+          if(sim_push(now + sim_hop_delay(), SIM_HEAL, hop, e.a, e.b)) goto oom;
+        } else if(u == 0) {
+          /* No route to the endpoint yet; retry once the DODAG settles */
+          heal_reroutes++;
+          if(sim_push(now + SIM_DIO_INTERVAL, SIM_HEAL, 0, e.a, e.b)) goto oom;
+        } else {
+          /* Stale route: back up the tree to the root */
+          heal_reroutes++;
+          double up = sim_rank[u] == SIM_UNRANKED ? SIM_DIO_INTERVAL : sim_rank[u] * sim_hop_delay();
+          if(sim_push(now + up, SIM_HEAL, 0, e.a, e.b)) goto oom;
+        }
+      }
+      break;
+    }
+  }
+
+  double wall = get_time_ms() - wall_start;
+  find_cut_vertices();
+  int cut_final = 0;
+  for(int i=0; i<n_nodes; i++) if(is_cut[i]) cut_final++;
+
+  printf("\nMote simulation: %d motes, %d links, %.1f s simulated\n",
+         n_nodes, original_edges, now);
+  printf("  all joined        %s%8.3f s\n", t_joined < 0 ? "never " : "", t_joined);
+  printf("  all reported      %s%8.3f s\n", t_reports < 0 ? "never " : "", t_reports);
+  printf("  detection         %s%8.3f s  (%d cut vertices)\n",
+         t_detect < 0 ? "never " : "", t_detect, cut_at_detect);
+  printf("  healing delivered %s%8.3f s  (%d of %d links in %d rounds, %d cut vertices left)\n",
+         t_healed < 0 ? "never " : "", t_healed, heal_done, heal_links, rounds, cut_final);
+  printf("  %d links refused at the endpoints, %ld commands re-routed\n",
+         heal_refused, heal_reroutes);
+  printf("  events:");
+  for(int k=0; k<6; k++) printf(" %s %ld%s", kind_names[k], msgs[k], k < 5 ? "," : "\n");
+  printf("  %ld events in %.2f ms wall, %.0f simulated s per wall s\n\n",
+         events, wall, wall > 0 ? now / (wall / 1000.0) : 0.0);
+
+  free(sim_heap);
+  sim_heap = NULL;
+  sim_heap_cap = 0;
+  return;
+
+oom:
+  LOG_ERR("Out of memory for simulation event queue\n");
+  free(sim_heap);
+  sim_heap = NULL;
+  sim_heap_cap = 0;
+}
+
+/* ----------------- Command line ------------------ */
+
+/* Usage: <nodes> [--topology=random|path|star-chains|bipartite|hub|petals]
+ *                [--chain-len=N] [--stress] [--export-csr=FILE]
+ *        --external=FILE [--gen-external=N] [--mem-budget=MB]
+ *                        [--hier [--parts=K]]
+ *        --numa-bench=N [--threads=T] [--pin=none|compact|scatter]
+ *        --tlb-bench=N [--hugepages=off|thp|explicit]
+ *        --prefetch-bench=N [--prefetch=D]
+ *        [--engine=tarjan|chain] --engine-bench=N
+ *        [--blocks=edge|vertex] --blocks-bench
+ *        [--pairing=sequential|spatial] [--heal-rounds=N]
+ *        [--augment=direct|relay] --whatif-bench=P [--whatif-nodes=N]
+ *        --version-bench=N [--threads=T] --query-bench [--threads=T]
+ *        [--coop=MS] [--sim=SECONDS] [--select=id|energy]
+ *        --sssp-bench=N --hier-bench=N [--parts=K] [--threads=T]
+ *        [--threads=auto | --threads=T --autotune]
+ *        [--engine=auto] [--profile=PATH] [--seed=S]
+ *        --verify-determinism[=N] */
+void parse_arguments(void) {
+  for(int a=1; a<contiki_argc; a++) {
+    const char *arg = contiki_argv[a];
+
+    if(strncmp(arg, "--topology=", 11) == 0) {
+      int found = 0;
+      for(int k=0; k<TOPO_COUNT; k++) {
+        if(strcmp(arg + 11, topology_names[k]) == 0) {
+          topology_kind = (topology_kind_t)k;
+          found = 1;
+        }
+      }
+      if(!found) printf("Unknown topology '%s'. Using: %s\n",
+                        arg + 11, topology_names[topology_kind]);
+    } else if(strncmp(arg, "--chain-len=", 12) == 0) {
+      stress_chain_len = atoi(arg + 12);
+    } else if(strcmp(arg, "--stress") == 0) {
+      stress_mode = 1;
+    } else if(strncmp(arg, "--external=", 11) == 0) {
+      external_file = arg + 11;
+    } else if(strncmp(arg, "--gen-external=", 15) == 0) {
+      external_gen_nodes = atoi(arg + 15);
+    } else if(strcmp(arg, "--hier") == 0) {
+      external_hier = 1;
+    } else if(strncmp(arg, "--mem-budget=", 13) == 0) {
+      mem_budget_mb = atol(arg + 13);
+    } else if(strncmp(arg, "--export-csr=", 13) == 0) {
+      export_csr_file = arg + 13;
+    } else if(strncmp(arg, "--numa-bench=", 13) == 0) {
+      numa_bench_nodes = atoi(arg + 13);
+    } else if(strcmp(arg, "--threads=auto") == 0) {
+      long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+      num_threads = cpus < 1 ? 1 : cpus > MAX_CPUS ? MAX_CPUS : (int)cpus;
+      autotune = 1;
+    } else if(strcmp(arg, "--autotune") == 0) {
+      autotune = 1;
+    } else if(strncmp(arg, "--threads=", 10) == 0) {
+      num_threads = atoi(arg + 10);
+      if(num_threads < 1) num_threads = 1;
+      if(num_threads > MAX_CPUS) num_threads = MAX_CPUS;
+    } else if(strncmp(arg, "--seed=", 7) == 0) {
+      topology_seed = (unsigned int)strtoul(arg + 7, NULL, 10);
+    } else if(strcmp(arg, "--verify-determinism") == 0) {
+      verify_threads = 8;
+    } else if(strncmp(arg, "--verify-determinism=", 21) == 0) {
+      verify_threads = atoi(arg + 21);
+      if(verify_threads < 2) verify_threads = 2;
+      if(verify_threads > MAX_CPUS) verify_threads = MAX_CPUS;
+    } else if(strcmp(arg, "--engine=auto") == 0) {
+      engine_auto = 1;
+    } else if(strncmp(arg, "--profile=", 10) == 0) {
+      profile_path = arg + 10;
+    } else if(strncmp(arg, "--engine=", 9) == 0) {
+      for(int k=0; k<2; k++) {
+        if(strcmp(arg + 9, engine_names[k]) == 0) analysis_engine = (engine_t)k;
+      }
+    } else if(strncmp(arg, "--blocks=", 9) == 0) {
+      for(int k=0; k<2; k++) {
+        if(strcmp(arg + 9, extraction_names[k]) == 0) block_extraction = (extraction_t)k;
+      }
+    } else if(strncmp(arg, "--pairing=", 10) == 0) {
+      for(int k=0; k<2; k++) {
+        if(strcmp(arg + 10, pairing_names[k]) == 0) pairing_mode = (pairing_t)k;
+      }
+    } else if(strncmp(arg, "--augment=", 10) == 0) {
+      for(int k=0; k<2; k++) {
+        if(strcmp(arg + 10, augment_names[k]) == 0) augment_mode = (augment_t)k;
+      }
+    } else if(strncmp(arg, "--heal-rounds=", 14) == 0) {
+      heal_rounds = atoi(arg + 14);
+      if(heal_rounds < 1) heal_rounds = 1;
+    } else if(strncmp(arg, "--whatif-bench=", 15) == 0) {
+      whatif_bench_plans = atoi(arg + 15);
+    } else if(strncmp(arg, "--sssp-bench=", 13) == 0) {
+      sssp_bench_nodes = atoi(arg + 13);
+    } else if(strncmp(arg, "--hier-bench=", 13) == 0) {
+      hier_bench_nodes = atoi(arg + 13);
+    } else if(strncmp(arg, "--parts=", 8) == 0) {
+      hier_parts = atoi(arg + 8);
+    } else if(strncmp(arg, "--select=", 9) == 0) {
+      for(int k=0; k<2; k++) {
+        if(strcmp(arg + 9, select_names[k]) == 0) select_mode = (select_t)k;
+      }
+    } else if(strncmp(arg, "--sim=", 6) == 0) {
+      sim_seconds = atof(arg + 6);
+    } else if(strncmp(arg, "--coop=", 7) == 0) {
+      coop_slice_ms = atof(arg + 7);
+      if(coop_slice_ms < 0) coop_slice_ms = 0;
+    } else if(strcmp(arg, "--query-bench") == 0) {
+      query_bench = 1;
+    } else if(strncmp(arg, "--version-bench=", 16) == 0) {
+      version_bench_nodes = atoi(arg + 16);
+    } else if(strncmp(arg, "--whatif-nodes=", 15) == 0) {
+      whatif_bench_nodes = atoi(arg + 15);
+    } else if(strcmp(arg, "--blocks-bench") == 0) {
+      blocks_bench = 1;
+    } else if(strncmp(arg, "--engine-bench=", 15) == 0) {
+      engine_bench_nodes = atoi(arg + 15);
+    } else if(strncmp(arg, "--prefetch-bench=", 17) == 0) {
+      prefetch_bench_nodes = atoi(arg + 17);
+    } else if(strncmp(arg, "--prefetch=", 11) == 0) {
+      prefetch_distance = atoi(arg + 11);
+      if(prefetch_distance < 0) prefetch_distance = 0;
+    } else if(strncmp(arg, "--tlb-bench=", 12) == 0) {
+      tlb_bench_nodes = atoi(arg + 12);
+    } else if(strncmp(arg, "--hugepages=", 12) == 0) {
+      for(int k=0; k<3; k++) {
+        if(strcmp(arg + 12, hugepage_names[k]) == 0) hugepage_mode = (hugepage_mode_t)k;
+      }
+    } else if(strncmp(arg, "--pin=", 6) == 0) {
+      for(int k=0; k<3; k++) {
+        if(strcmp(arg + 6, pin_names[k]) == 0) pin_policy = (pin_policy_t)k;
+      }
+    } else if(arg[0] == '-') {
+      printf("Unknown option '%s' ignored\n", arg);
+    } else {
+      int user_nodes = atoi(arg);
+      if(user_nodes >= 10 && user_nodes <= MAX_NODES) {
+        n_nodes = user_nodes;
+        LOG_INFO("Using node count: %d\n", n_nodes);
+      } else {
+        printf("Invalid node count. Must be 10-%d. Using: %d\n", 
+               MAX_NODES, n_nodes);
+      }
+    }
+  }
 }
 
 /* ----------------- Contiki process ------------------ */
@@ -548,16 +7159,9 @@ PROCESS_THREAD(cut_vertex_mesh_process, ev, data)
   PROCESS_BEGIN();
   
   /* Parse command-line arguments */
-  if(contiki_argc > 1) {
-    int user_nodes = atoi(contiki_argv[1]);
-    if(user_nodes >= 10 && user_nodes <= MAX_NODES) {
-      n_nodes = user_nodes;
-      LOG_INFO("Using node count: %d\n", n_nodes);
-    } else {
-      printf("Invalid node count. Must be 10-%d. Using: %d\n", 
-             MAX_NODES, n_nodes);
-    }
-  }
+  parse_arguments();
+  advise_static_hugepages();
+  profile_load();
   
   printf("\n╔════════════════════════════════════════════════════════════╗\n");
   printf("║         RPL MESHIFICATION ALGORITHM DEMO                  ║\n");
@@ -566,8 +7170,50 @@ PROCESS_THREAD(cut_vertex_mesh_process, ev, data)
   printf("║ Target: Eliminate All Cut Vertices (Biconnectivity)       ║\n");
   printf("╚════════════════════════════════════════════════════════════╝\n\n");
   
-  run_meshification();
+  if(external_file) {
+    if(external_gen_nodes <= 1 ||
+       csr_generate_file(external_file, external_gen_nodes) == 0) {
+      if(external_hier) run_external_hier(external_file);
+      else run_external_analysis(external_file, mem_budget_mb);
+    }
+  } else if(verify_threads > 0) {
+    run_determinism_check(verify_threads);
+  } else if(hier_bench_nodes > 1) {
+    run_hier_benchmark(hier_bench_nodes);
+  } else if(sssp_bench_nodes > 1) {
+    run_sssp_benchmark(sssp_bench_nodes);
+  } else if(query_bench) {
+    run_query_benchmark();
+  } else if(version_bench_nodes > 1) {
+    run_version_benchmark(version_bench_nodes);
+  } else if(whatif_bench_plans > 0) {
+    run_whatif_benchmark(whatif_bench_plans, whatif_bench_nodes);
+  } else if(blocks_bench) {
+    run_blocks_benchmark();
+  } else if(engine_bench_nodes > 0) {
+    run_engine_benchmark(engine_bench_nodes);
+  } else if(prefetch_bench_nodes > 0) {
+    run_prefetch_benchmark(prefetch_bench_nodes);
+  } else if(tlb_bench_nodes > 0) {
+    run_tlb_benchmark(tlb_bench_nodes);
+  } else if(numa_bench_nodes > 0) {
+    run_numa_benchmark(numa_bench_nodes);
+  } else if(stress_mode) {
+    run_stress_benchmark();
+  } else if(sim_seconds > 0) {
+    run_mote_simulation(sim_seconds);
+  } else if(coop_slice_ms > 0) {
+    /* Analysis state is static, so it survives each pause */
+    coop_begin();
+    while(!coop_step()) {
+      PROCESS_PAUSE();
+    }
+    coop_finish();
+  } else {
+    run_meshification();
+  }
   
+  profile_save();
   LOG_INFO("Process complete. Check output files.\n");
   
   PROCESS_END();